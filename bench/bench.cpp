@@ -0,0 +1,72 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "runtime/interpreter.hpp"
+#include "util/error.hpp"
+#include "util/file.hpp"
+
+// Runs every script a few times on a fresh interpreter and reports the best
+// wall time. Build once as `bench` and once as `bench_switch` to compare the
+// threaded dispatch against the plain switch, and as `bench_no_budget` to
+// see what the instruction budget check costs. `--no-jit` keeps every
+// confection in the interpreter, where the budget is counted.
+static std::vector<Token> tokenize(Lexer &lexer) {
+    lexer.retokenize();
+    std::vector<Token> tokens;
+    Token token = lexer.next();
+    while (token.type != TokenType::END) {
+        tokens.push_back(token);
+        token = lexer.next();
+    }
+    tokens.push_back(token); // add the end token
+    return tokens;
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> files;
+    InterpreterOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--no-jit") {
+            options.jit = false;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        files.push_back("./bench/cases/loops.choco");
+        files.push_back("./bench/cases/calls.choco");
+    }
+
+    constexpr int runs = 5;
+    try {
+        for (const auto &file : files) {
+            std::string source = load_file(file);
+            Lexer lexer{source};
+            Parser parser{tokenize(lexer)};
+            auto &ast = parser.parse();
+
+            double best = std::numeric_limits<double>::max();
+            for (int r = 0; r < runs; ++r) {
+                Interpreter choco{options};
+                auto start = std::chrono::steady_clock::now();
+                choco.eval(ast);
+                auto end = std::chrono::steady_clock::now();
+                best = std::min(
+                    best,
+                    std::chrono::duration<double, std::milli>(end - start)
+                        .count());
+            }
+            fmt::println("{}: {:.2f} ms (best of {})", file, best, runs);
+        }
+    } catch (const Error &error) {
+        return error.output_error();
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+# choco_add_executable(<target> <script.choco>)
+#
+# builds a script into a native executable: `choco --emit-cpp` translates it
+# to C++ again whenever it changes, which is then compiled against the
+# choco_runtime library
+function(choco_add_executable target script)
+    get_filename_component(script ${script} ABSOLUTE)
+    set(generated ${CMAKE_CURRENT_BINARY_DIR}/${target}.cpp)
+    add_custom_command(
+        OUTPUT ${generated}
+        COMMAND choco --emit-cpp ${script} -o ${generated}
+        DEPENDS choco ${script}
+        COMMENT "Translating ${script} to C++"
+        VERBATIM
+    )
+    add_executable(${target} ${generated})
+    target_link_libraries(${target} PRIVATE choco_runtime)
+endfunction()
@@ -1,13 +1,242 @@
 #include "ast.hpp"
 
+#include <fmt/core.h>
+
 #include <sstream>
 
 std::string DotExpr::full_expr() const {
     std::stringstream ss;
-    auto symbol = static_cast<SymbolExpr *>(head.get());
-    ss << symbol->symbol;
+    // a subscript head is dumped as a child instead
+    if (head->type == ASTNodeType::SYMBOL) {
+        ss << static_cast<SymbolExpr *>(head.get())->symbol;
+    }
     for (auto &symbol : after) {
+        // the arguments of a method call are dumped as children
+        if (symbol->type == ASTNodeType::FUNCTION_CALL) {
+            ss << "." << static_cast<CallExpr *>(symbol.get())->callee->symbol
+               << "()";
+            continue;
+        }
         ss << "." << static_cast<SymbolExpr *>(symbol.get())->symbol;
     }
     return ss.str();
 }
+
+static std::string op_symbol(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS:
+            return "+";
+        case TokenType::MINUS:
+            return "-";
+        case TokenType::MUL:
+            return "*";
+        case TokenType::DIV:
+            return "/";
+        case TokenType::LT:
+            return "<";
+        case TokenType::GT:
+            return ">";
+        case TokenType::LOT:
+            return "<=";
+        case TokenType::GOT:
+            return ">=";
+        case TokenType::EQUALS:
+            return "==";
+        case TokenType::NOT_EQUAL:
+            return "!=";
+        case TokenType::AND:
+            return "&&";
+        case TokenType::OR:
+            return "||";
+        case TokenType::NOT:
+            return "!";
+        default:
+            return type_to_string(op);
+    }
+}
+
+static void dump_node(std::stringstream &ss, ASTNode *node, int depth);
+
+static void dump_block(std::stringstream &ss,
+                       const std::string &label,
+                       const std::vector<uptr<Statement>> &statements,
+                       int depth) {
+    ss << std::string(depth * 2, ' ') << label << "\n";
+    for (const auto &s : statements) {
+        dump_node(ss, s.get(), depth + 1);
+    }
+}
+
+static void dump_node(std::stringstream &ss, ASTNode *node, int depth) {
+    std::string indent(depth * 2, ' ');
+    switch (node->type) {
+        case ASTNodeType::VARIABLE_DECLARATION:
+        case ASTNodeType::VARIABLE_REASSIGN: {
+            auto v = ast_cast<VariableDeclaration>(node);
+            bool declaration = v->type == ASTNodeType::VARIABLE_DECLARATION;
+            ss << indent << (declaration ? "Let " : "Assign ") << v->name;
+            if (v->annotation != Annotation::NONE) {
+                ss << ": " << annotation_name(v->annotation);
+            }
+            ss << "\n";
+            dump_node(ss, v->value.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::IF_STATEMENT: {
+            auto s = ast_cast<IfExpr>(node);
+            ss << indent << "If\n";
+            dump_node(ss, s->condition.get(), depth + 1);
+            dump_block(ss, "Then", s->statements, depth + 1);
+            for (const auto &elif : s->elif_statements) {
+                ss << indent << "Elif\n";
+                dump_node(ss, elif->condition.get(), depth + 1);
+                dump_block(ss, "Then", elif->statements, depth + 1);
+            }
+            if (!s->else_statements.empty()) {
+                dump_block(ss, "Else", s->else_statements, depth);
+            }
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            auto s = ast_cast<WhileExpr>(node);
+            ss << indent << "While\n";
+            dump_node(ss, s->condition.get(), depth + 1);
+            dump_block(ss, "Do", s->statements, depth + 1);
+            return;
+        }
+        case ASTNodeType::BLOCK: {
+            dump_block(ss, "Block", ast_cast<BlockExpr>(node)->statements,
+                       depth);
+            return;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION: {
+            auto s = ast_cast<FunctionDefExpr>(node);
+            std::string params;
+            for (size_t i = 0; i < s->params.size(); ++i) {
+                if (i > 0) params += ", ";
+                if (s->param_types[i] != Annotation::NONE) {
+                    params += annotation_name(s->param_types[i]);
+                    params += " ";
+                }
+                params += s->params[i];
+            }
+            dump_block(ss,
+                       fmt::format("Confection {}({})", s->name, params),
+                       s->statements,
+                       depth);
+            return;
+        }
+        case ASTNodeType::RETURN_STATEMENT: {
+            ss << indent << "Gift\n";
+            dump_node(ss, ast_cast<ReturnExpr>(node)->content.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::CLASS_DEFINITION: {
+            auto s = ast_cast<ClassDefinitionExpr>(node);
+            ss << indent << "Box " << s->name << "\n";
+            for (const auto &attr : s->attributes) {
+                dump_node(ss, attr.get(), depth + 1);
+            }
+            for (const auto &method : s->methods) {
+                dump_node(ss, method.get(), depth + 1);
+            }
+            return;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            auto s = ast_cast<ObjectAttrReassignExpr>(node);
+            ss << indent << "AssignAttr\n";
+            dump_node(ss, s->head.get(), depth + 1);
+            dump_node(ss, s->right.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            auto s = ast_cast<IndexAssignExpr>(node);
+            ss << indent << "AssignIndex\n";
+            dump_node(ss, s->head.get(), depth + 1);
+            dump_node(ss, s->right.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::OBJECT_INSTANTIATION: {
+            auto s = ast_cast<ObjectInstantiationExpr>(node);
+            ss << indent << "New " << s->class_name << "\n";
+            return;
+        }
+        case ASTNodeType::LITERAL: {
+            Value value = ast_cast<LiteralExpr>(node)->value;
+            if (value.type() == ValueType::STRING) {
+                ss << indent << "Literal \"" << literal_to_string(value)
+                   << "\"\n";
+            } else {
+                ss << indent << "Literal " << literal_to_string(value) << "\n";
+            }
+            return;
+        }
+        case ASTNodeType::LIST: {
+            ss << indent << "List\n";
+            for (const auto &element : ast_cast<ListExpr>(node)->elements) {
+                dump_node(ss, element.get(), depth + 1);
+            }
+            return;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(node);
+            ss << indent << "Binary " << op_symbol(v->op) << "\n";
+            dump_node(ss, v->left.get(), depth + 1);
+            dump_node(ss, v->right.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::UNARY: {
+            auto v = ast_cast<UnaryExpr>(node);
+            ss << indent << "Unary " << op_symbol(v->op) << "\n";
+            dump_node(ss, v->unary.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::SYMBOL: {
+            ss << indent << "Symbol " << ast_cast<SymbolExpr>(node)->symbol
+               << "\n";
+            return;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(node);
+            ss << indent << "Dot " << v->full_expr() << "\n";
+            if (v->head->type != ASTNodeType::SYMBOL) {
+                dump_node(ss, v->head.get(), depth + 1);
+            }
+            for (const auto &after : v->after) {
+                if (after->type != ASTNodeType::FUNCTION_CALL) continue;
+                auto call = ast_cast<CallExpr>(after.get());
+                for (const auto &param : call->params) {
+                    dump_node(ss, param.get(), depth + 1);
+                }
+            }
+            return;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(node);
+            ss << indent << "Index\n";
+            dump_node(ss, v->container.get(), depth + 1);
+            dump_node(ss, v->index.get(), depth + 1);
+            return;
+        }
+        case ASTNodeType::FUNCTION_CALL: {
+            auto s = ast_cast<CallExpr>(node);
+            ss << indent << "Call " << s->callee->symbol << "\n";
+            for (const auto &param : s->params) {
+                dump_node(ss, param.get(), depth + 1);
+            }
+            return;
+        }
+        default: {
+            ss << indent << "?\n";
+            return;
+        }
+    }
+}
+
+std::string dump_ast(const std::vector<uptr<Statement>> &ast) {
+    std::stringstream ss;
+    for (const auto &s : ast) {
+        dump_node(ss, s.get(), 0);
+    }
+    return ss.str();
+}
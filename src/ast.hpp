@@ -1,6 +1,8 @@
 #ifndef AST_HPP
 #define AST_HPP
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "runtime/value.hpp"
@@ -21,13 +23,34 @@ enum class ASTNodeType {
     CLASS_DEFINITION,
     OBJECT_INSTANTIATION,
     OBJECT_ATTR_REASSIGN,
+    INDEX_ASSIGN,
+    BLOCK,
     // expressions
     LITERAL,
     LIST,
     BINARY,
     UNARY,
     SYMBOL,
-    DOT_SYMBOL
+    DOT_SYMBOL,
+    INDEX
+};
+
+// filled in by the Resolver: the slot of a local in its function's frame,
+// globals live in the interpreter's global table instead
+struct Binding {
+    bool global = true;
+    uint32_t slot = 0;
+    // the variable's annotation, wherever it is used
+    Annotation type = Annotation::NONE;
+};
+
+// filled in by the Resolver: a call goes straight to a native or to the user
+// function in a slot of the interpreter's function table
+struct Callee {
+    enum Kind : uint8_t { NATIVE, FUNCTION };
+
+    Kind kind = FUNCTION;
+    uint32_t index = 0;
 };
 
 struct ASTNode {
@@ -39,6 +62,16 @@ struct ASTNode {
 
 using Statement = ASTNode;
 
+// ASTNode::type already names the concrete node, so casts are static and
+// only checked against RTTI in debug builds
+template <typename T>
+T *ast_cast(ASTNode *node) {
+#ifndef NDEBUG
+    ASSERT(dynamic_cast<T *>(node) != nullptr, "invalid AST node cast\n");
+#endif
+    return static_cast<T *>(node);
+}
+
 struct Expr : public ASTNode {
     Expr() = default;
     virtual ~Expr() = default;
@@ -49,7 +82,9 @@ struct LiteralExpr : public Expr {
     LiteralExpr() : Expr() {
         type = ASTNodeType::LITERAL;
     }
-    uptr<LiteralValue> value = nullptr;
+    Value value;
+    // keeps the StringValue of a string literal alive
+    uptr<HeapValue> object = nullptr;
 };
 
 struct ListExpr : public LiteralExpr {
@@ -74,6 +109,7 @@ struct SymbolExpr : public Expr {
         type = ASTNodeType::SYMBOL;
     }
     std::string symbol;
+    Binding binding;
 };
 
 struct BinaryExpr : public Expr {
@@ -90,6 +126,11 @@ struct VariableDeclaration : public Expr {
     }
     std::string name;
     uptr<Expr> value;
+    Annotation annotation = Annotation::NONE;
+    Binding binding;
+    // an attribute of a box the Optimizer keeps in a local, reassigning it
+    // follows the type rule of `obj.attr = value`
+    bool attribute = false;
 };
 
 // children: statements
@@ -99,6 +140,7 @@ struct CallExpr : public Expr {
     }
     uptr<SymbolExpr> callee;
     std::vector<uptr<Expr>> params;
+    Callee target;
 };
 
 struct FunctionDefExpr : public Expr {
@@ -107,7 +149,13 @@ struct FunctionDefExpr : public Expr {
     }
     std::string name;
     std::vector<std::string> params;
+    // one per parameter
+    std::vector<Annotation> param_types;
     std::vector<uptr<Statement>> statements;
+    // slot in the interpreter's function table
+    uint32_t slot = 0;
+    // frame size: the parameters then the locals of every block
+    uint32_t frame_slots = 0;
 };
 
 struct ReturnExpr : public Expr {
@@ -136,6 +184,14 @@ struct IfExpr : public Expr {
     std::vector<uptr<Statement>> else_statements;
 };
 
+// a scope on its own, what is left of an if once its condition is known
+struct BlockExpr : public Expr {
+    BlockExpr() : Expr() {
+        type = ASTNodeType::BLOCK;
+    }
+    std::vector<uptr<Statement>> statements;
+};
+
 struct WhileExpr : public Expr {
     WhileExpr() : Expr() {
         type = ASTNodeType::WHILE_STATEMENT;
@@ -150,6 +206,9 @@ struct ClassDefinitionExpr : public Expr {
     }
     std::string name;
     std::vector<uptr<VariableDeclaration>> attributes;
+    // called as `obj.name(...)`, named `Box.name` with the instance as their
+    // first parameter `self`
+    std::vector<uptr<FunctionDefExpr>> methods;
 };
 
 struct ObjectInstantiationExpr : public Expr {
@@ -179,4 +238,24 @@ struct ObjectAttrReassignExpr : public Expr {
     uptr<Expr> right;
 };
 
+// container[index]
+struct IndexExpr : public Expr {
+    IndexExpr() : Expr() {
+        type = ASTNodeType::INDEX;
+    }
+    uptr<Expr> container;
+    uptr<Expr> index;
+};
+
+struct IndexAssignExpr : public Expr {
+    IndexAssignExpr() : Expr() {
+        type = ASTNodeType::INDEX_ASSIGN;
+    }
+    uptr<IndexExpr> head;
+    uptr<Expr> right;
+};
+
+// one node per line, children indented below their parent
+std::string dump_ast(const std::vector<uptr<Statement>> &ast);
+
 #endif // AST_HPP
@@ -0,0 +1,38 @@
+#include "bytecode.hpp"
+
+size_t Chunk::emit(OpCode op, uint16_t a, uint32_t b) {
+    code.push_back({op, a, b});
+    return code.size() - 1;
+}
+
+void Chunk::patch_jump(size_t at) {
+    code[at].b = code.size();
+}
+
+uint32_t Chunk::add_constant(Value value) {
+    constants.push_back(value);
+    return constants.size() - 1;
+}
+
+uint32_t Chunk::add_name(const std::string &name) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == name) return i;
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+uint32_t Chunk::add_attr_cache(const std::string &name) {
+    attr_caches.push_back({add_name(name)});
+    return attr_caches.size() - 1;
+}
+
+uint32_t Chunk::add_class_cache(const std::string &name) {
+    class_caches.push_back({add_name(name)});
+    return class_caches.size() - 1;
+}
+
+uint32_t Chunk::add_method_cache(const std::string &name) {
+    method_caches.push_back({add_name(name)});
+    return method_caches.size() - 1;
+}
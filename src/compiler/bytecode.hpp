@@ -0,0 +1,205 @@
+#ifndef COMPILER_BYTECODE_HPP
+#define COMPILER_BYTECODE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "runtime/value.hpp"
+#include "util/util.hpp"
+
+// operands live in Instruction::a (small counts) and Instruction::b (indices
+// into the chunk's constant/name pools, jump targets, function/class ids).
+// The list drives both the enum and the VM's dispatch table, so the two
+// can never get out of order.
+#define CHOCO_OPCODES(X)                                                       \
+    /* stack */                                                                \
+    X(CONSTANT) /* push constants[b] */                                        \
+    X(NONE)     /* push None */                                                \
+    X(POP)                                                                     \
+    /* variables, b = slot in the frame or in the global table */              \
+    X(GET_LOCAL)                                                               \
+    X(SET_LOCAL)                                                               \
+    X(TEE_LOCAL) /* SET_LOCAL that leaves the value on the stack */            \
+    /* SET_LOCAL with the type rule of SET_ATTR, for the attributes of a box   \
+       the Optimizer keeps in locals */                                        \
+    X(SET_LOCAL_ATTR)                                                          \
+    X(GET_GLOBAL)                                                              \
+    X(SET_GLOBAL)                                                              \
+    X(DEFINE_GLOBAL)                                                           \
+    /* objects and lists */                                                    \
+    X(GET_ATTR)   /* push pop().attr, attr_caches[b] holds the name */         \
+    X(SET_ATTR)   /* value = pop(), obj = pop(), obj.attr = value */           \
+    X(NEW_OBJECT) /* push a new instance of the box of class_caches[b] */      \
+    X(INIT_ATTR)  /* pop() into slot b of the constructor's new instance */    \
+    X(LIST)       /* pop a values into a new list */                           \
+    X(GET_INDEX)  /* index = pop(), push pop()[index] */                       \
+    X(SET_INDEX)  /* value = pop(), index = pop(), pop()[index] = value */     \
+    /* operators */                                                            \
+    X(ADD)                                                                     \
+    X(SUB)                                                                     \
+    X(MUL)                                                                     \
+    X(DIV)                                                                     \
+    X(LT)                                                                      \
+    X(GT)                                                                      \
+    X(LOT)                                                                     \
+    X(GOT)                                                                     \
+    X(EQUALS)                                                                  \
+    X(NOT_EQUAL)                                                               \
+    X(NEGATE)                                                                  \
+    X(NOT)                                                                     \
+    X(ADD_IN_PLACE) /* ADD appending to the string a CONCAT just made */       \
+    X(CONCAT) /* the ADD starting the string of a ConcatChain, room for b */   \
+    /* quickened by the VM from the operators above once a site sees           \
+       two numbers (or two strings), a = 1 keeps a site that failed the        \
+       guard generic */                                                        \
+    X(ADD_NUM)                                                                 \
+    X(SUB_NUM)                                                                 \
+    X(MUL_NUM)                                                                 \
+    X(DIV_NUM)                                                                 \
+    X(LT_NUM)                                                                  \
+    X(GT_NUM)                                                                  \
+    X(LOT_NUM)                                                                 \
+    X(GOT_NUM)                                                                 \
+    X(EQUALS_NUM)                                                              \
+    X(NOT_EQUAL_NUM)                                                           \
+    X(ADD_STR)                                                                 \
+    /* the operator ADD + a on a number left on the stack and a typed          \
+       number, no guards since the compiler proved both are numbers */         \
+    X(NUM_LOCAL) /* the right side is the number in local slot b */            \
+    X(NUM_CONST) /* the right side is the number constant b */                 \
+    /* fails with a TYPE_ERROR if the value on top doesn't fit annotation a    \
+       of the variable names[b], leaves it on the stack */                     \
+    X(CHECK_TYPE)                                                              \
+    /* control flow, b is an absolute instruction index */                     \
+    X(JUMP)                                                                    \
+    X(JUMP_IF_FALSE)                                                           \
+    X(JUMP_IF_TRUE)                                                            \
+    X(LOOP)                                                                    \
+    /* pop right and left, jump to b if (left op right) == a */                \
+    X(JUMP_LT)                                                                 \
+    X(JUMP_GT)                                                                 \
+    X(JUMP_LOT)                                                                \
+    X(JUMP_GOT)                                                                \
+    X(JUMP_EQUALS)                                                             \
+    X(JUMP_NOT_EQUAL)                                                          \
+    /* functions and classes */                                                \
+    X(CALL)        /* call function slot b with the top a values */            \
+    X(TAIL_CALL)   /* CALL that replaces the current frame */                  \
+    X(CALL_NATIVE) /* call native b with the top a values */                   \
+    /* call the method of method_caches[b] on the instance under the top a     \
+       values, the instance is its first argument */                           \
+    X(CALL_METHOD)                                                             \
+    X(DEFINE_FUNCTION) /* functions[b] of the program */                       \
+    X(DEFINE_CLASS)                                                            \
+    X(RETURN)
+
+enum class OpCode : uint8_t {
+#define CHOCO_OPCODE_ENUM(name) name,
+    CHOCO_OPCODES(CHOCO_OPCODE_ENUM)
+#undef CHOCO_OPCODE_ENUM
+};
+
+struct Instruction {
+    OpCode op;
+    uint16_t a = 0;
+    uint32_t b = 0;
+};
+
+inline bool is_jump(OpCode op) {
+    return op >= OpCode::JUMP && op <= OpCode::JUMP_NOT_EQUAL;
+}
+
+// the operator a quickened instruction was specialized from
+inline OpCode generic_op(OpCode op) {
+    if (op >= OpCode::ADD_NUM && op <= OpCode::NOT_EQUAL_NUM) {
+        return (OpCode)((int)OpCode::ADD + (int)op - (int)OpCode::ADD_NUM);
+    }
+    if (op == OpCode::ADD_STR) return OpCode::ADD;
+    return op;
+}
+
+// a monomorphic inline cache: the slot of the attribute in the last shape
+// seen at one GET_ATTR/SET_ATTR
+struct AttrCache {
+    uint32_t name;
+    const Shape *shape = nullptr;
+    uint32_t slot = 0;
+};
+
+struct Class;
+struct Function;
+
+// the box a NEW_OBJECT site instantiates, found by name the first time the
+// site runs. A box can't be declared twice, so it stays right from then on
+struct ClassCache {
+    uint32_t name;
+    const Class *value = nullptr;
+};
+
+// the method an `obj.name(...)` site called on the last shape it saw, a
+// method call that hits costs what a CALL does
+struct MethodCache {
+    uint32_t name;
+    const Shape *shape = nullptr;
+    const Function *function = nullptr;
+};
+
+struct Chunk {
+    size_t emit(OpCode op, uint16_t a = 0, uint32_t b = 0);
+    // points the jump at `at` to the next instruction to be emitted
+    void patch_jump(size_t at);
+    uint32_t add_constant(Value value);
+    uint32_t add_name(const std::string &name);
+    uint32_t add_attr_cache(const std::string &name);
+    uint32_t add_class_cache(const std::string &name);
+    uint32_t add_method_cache(const std::string &name);
+
+    // the VM quickens instructions in place as it runs
+    mutable std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<std::string> names;
+    // filled in by the VM as it runs
+    mutable std::vector<AttrCache> attr_caches;
+    mutable std::vector<ClassCache> class_caches;
+    mutable std::vector<MethodCache> method_caches;
+};
+
+// machine code for a function, runs directly on the frame's slots
+using JitFn = Value (*)(Value *slots);
+
+struct Function {
+    std::string name;
+    std::vector<std::string> params;
+    // the annotation of each parameter, empty if none has one
+    std::vector<Annotation> param_types;
+    // frame size, parameters first, then the locals of every block
+    uint32_t slots = 0;
+    // where DEFINE_FUNCTION puts it in the interpreter's function table
+    uint32_t slot = 0;
+    Chunk chunk;
+
+    // tier-up state of the VM, see Jit
+    uint32_t calls = 0;
+    JitFn native = nullptr;
+};
+
+struct Class {
+    std::string name;
+    Shape shape;
+    // every instance starts as a copy of this: the literal default values,
+    // None where a default has to be evaluated each time
+    std::vector<Value> prototype;
+    // evaluates those defaults into the copy in its slot 0, empty when
+    // every default is a literal
+    Function constructor;
+};
+
+// everything the compiler produced for one source file
+struct Program {
+    Function main;
+    std::vector<uptr<Function>> functions;
+    std::vector<uptr<Class>> classes;
+};
+
+#endif // COMPILER_BYTECODE_HPP
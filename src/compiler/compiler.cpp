@@ -0,0 +1,714 @@
+#include "compiler.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+
+#include "ast.hpp"
+#include "compiler/bytecode.hpp"
+#include "compiler/loads.hpp"
+#include "token.hpp"
+#include "util/error.hpp"
+
+static bool is_number_type(Annotation type) {
+    return type == Annotation::NUMBER || type == Annotation::WHOLE ||
+           type == Annotation::UNSIGNED;
+}
+
+// true if a value of static type value always fits a variable annotated type
+static bool fits_statically(Annotation type, Annotation value) {
+    switch (type) {
+        case Annotation::NONE:
+            return true;
+        case Annotation::NUMBER:
+            return is_number_type(value);
+        case Annotation::WHOLE:
+            return value == Annotation::WHOLE || value == Annotation::UNSIGNED;
+        default:
+            return value == type;
+    }
+}
+
+// the most the compiler knows about what expr evaluates to, NONE if it could
+// be anything
+static Annotation static_type(Expr *expr) {
+    switch (expr->type) {
+        case ASTNodeType::LITERAL: {
+            Value value = ast_cast<LiteralExpr>(expr)->value;
+            if (fits(Annotation::UNSIGNED, value)) return Annotation::UNSIGNED;
+            if (fits(Annotation::WHOLE, value)) return Annotation::WHOLE;
+            if (value.is_number()) return Annotation::NUMBER;
+            if (fits(Annotation::CHAR, value)) return Annotation::CHAR;
+            return Annotation::NONE;
+        }
+        case ASTNodeType::SYMBOL:
+            return ast_cast<SymbolExpr>(expr)->binding.type;
+        case ASTNodeType::UNARY: {
+            auto v = ast_cast<UnaryExpr>(expr);
+            Annotation type = static_type(v->unary.get());
+            if (v->op != TokenType::MINUS || !is_number_type(type)) {
+                return Annotation::NONE;
+            }
+            return type == Annotation::NUMBER ? type : Annotation::WHOLE;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            Annotation left = static_type(v->left.get());
+            Annotation right = static_type(v->right.get());
+            if (!is_number_type(left) || !is_number_type(right)) {
+                return Annotation::NONE;
+            }
+            switch (v->op) {
+                case TokenType::PLUS:
+                case TokenType::MUL:
+                    if (left == Annotation::UNSIGNED &&
+                        right == Annotation::UNSIGNED) {
+                        return Annotation::UNSIGNED;
+                    }
+                    [[fallthrough]];
+                case TokenType::MINUS:
+                    // whole numbers stay whole, even once they are too big
+                    // for a double to have a fraction
+                    if (left != Annotation::NUMBER &&
+                        right != Annotation::NUMBER) {
+                        return Annotation::WHOLE;
+                    }
+                    return Annotation::NUMBER;
+                case TokenType::DIV:
+                    return Annotation::NUMBER;
+                default:
+                    return Annotation::NONE;
+            }
+        }
+        default:
+            return Annotation::NONE;
+    }
+}
+
+static bool is_plus(Expr *expr) {
+    if (expr->type != ASTNodeType::BINARY) return false;
+    auto v = ast_cast<BinaryExpr>(expr);
+    return v->op == TokenType::PLUS;
+}
+
+static bool is_string_literal(Expr *expr) {
+    return expr->type == ASTNodeType::LITERAL &&
+           ast_cast<LiteralExpr>(expr)->value.type() == ValueType::STRING;
+}
+
+bool find_concat_chain(BinaryExpr *v, ConcatChain &chain) {
+    // the +s from the first to the last
+    std::vector<BinaryExpr *> steps;
+    Expr *first = v;
+    while (is_plus(first)) {
+        steps.push_back(ast_cast<BinaryExpr>(first));
+        first = steps.back()->left.get();
+    }
+    if (steps.size() < 2) return false;
+    std::reverse(steps.begin(), steps.end());
+    std::vector<Expr *> pieces{first};
+    for (BinaryExpr *step : steps) {
+        pieces.push_back(step->right.get());
+    }
+    auto literal =
+        std::find_if(pieces.begin(), pieces.end(), is_string_literal);
+    if (literal == pieces.end()) return false;
+
+    // the piece whose + makes the string
+    size_t start = std::max<size_t>(literal - pieces.begin(), 1);
+    chain.prefix = start == 1 ? pieces[0] : steps[start - 2];
+    chain.pieces.assign(pieces.begin() + start, pieces.end());
+    chain.size = 0;
+    for (Expr *piece : pieces) {
+        if (is_string_literal(piece)) {
+            Value value = ast_cast<LiteralExpr>(piece)->value;
+            chain.size += value.as<StringValue>()->value.size();
+        } else {
+            chain.size += 16;
+        }
+    }
+    return true;
+}
+
+Compiler::Compiler(Memory &memory, GlobalTable &globals,
+                   const InlineOptions &inlining)
+    : memory(memory), globals(globals), inlining(inlining) {}
+
+uptr<Program> Compiler::compile(const std::vector<uptr<Statement>> &ast,
+                                uint32_t main_slots) {
+    auto result = std::make_unique<Program>();
+    program = result.get();
+    program->main.name = "<main>";
+    program->main.slots = main_slots;
+
+    defined_at.clear();
+    std::vector<bool> top_level;
+    Chunk &chunk = program->main.chunk;
+    for (const auto &s : ast) {
+        compile_statement(s.get(), chunk);
+        // nested definitions come first, the top-level one is the last
+        top_level.resize(program->functions.size(), false);
+        if (s->type == ASTNodeType::FUNCTION_DEFINITION) {
+            top_level.back() = true;
+        }
+    }
+    chunk.emit(OpCode::NONE);
+    chunk.emit(OpCode::RETURN);
+    optimize_chunks(top_level);
+
+    program = nullptr;
+    return result;
+}
+
+void Compiler::compile_statement(Statement *statement, Chunk &chunk) {
+    switch (statement->type) {
+        case ASTNodeType::VARIABLE_REASSIGN:
+        case ASTNodeType::VARIABLE_DECLARATION: {
+            compile_variable_declaration(
+                ast_cast<VariableDeclaration>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::IF_STATEMENT: {
+            compile_if_statement(ast_cast<IfExpr>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            compile_while_statement(ast_cast<WhileExpr>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::BLOCK: {
+            compile_block(ast_cast<BlockExpr>(statement)->statements, chunk);
+            return;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION: {
+            compile_function_definition(
+                ast_cast<FunctionDefExpr>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::RETURN_STATEMENT: {
+            Expr *content = ast_cast<ReturnExpr>(statement)->content.get();
+            // gifting a call to a confection reuses the frame, the main
+            // chunk keeps its own since its slots are the top-level locals
+            bool tail_call =
+                &chunk != &program->main.chunk &&
+                content->type == ASTNodeType::FUNCTION_CALL &&
+                ast_cast<CallExpr>(content)->target.kind == Callee::FUNCTION;
+            if (tail_call) {
+                compile_function_call(
+                    ast_cast<CallExpr>(content), chunk, OpCode::TAIL_CALL);
+                return;
+            }
+            compile_expr(content, chunk);
+            chunk.emit(OpCode::RETURN);
+            return;
+        }
+        case ASTNodeType::CLASS_DEFINITION: {
+            compile_class_definition(
+                ast_cast<ClassDefinitionExpr>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            compile_object_attr_reassign(
+                ast_cast<ObjectAttrReassignExpr>(statement), chunk);
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            compile_index_assign(ast_cast<IndexAssignExpr>(statement), chunk);
+            return;
+        }
+        default: {
+            // expression statement, the value is discarded
+            compile_expr(ast_cast<Expr>(statement), chunk);
+            chunk.emit(OpCode::POP);
+            return;
+        }
+    }
+}
+
+void Compiler::compile_block(const std::vector<uptr<Statement>> &statements,
+                             Chunk &chunk) {
+    // block locals already have their own slots in the frame
+    for (const auto &s : statements) {
+        compile_statement(s.get(), chunk);
+    }
+}
+
+void Compiler::compile_variable_declaration(VariableDeclaration *v,
+                                            Chunk &chunk) {
+    compile_expr(v->value.get(), chunk);
+    Annotation type = v->binding.type;
+    bool fits = fits_statically(type, static_type(v->value.get()));
+    if (v->attribute && v->type == ASTNodeType::VARIABLE_REASSIGN) {
+        // a number attribute given a number can't change type
+        bool checked = !fits || type == Annotation::NONE;
+        chunk.emit(checked ? OpCode::SET_LOCAL_ATTR : OpCode::SET_LOCAL,
+                   0,
+                   v->binding.slot);
+        return;
+    }
+    // checked once here, so every read of the variable can trust it
+    if (!fits) {
+        chunk.emit(
+            OpCode::CHECK_TYPE, (uint16_t)type, chunk.add_name(v->name));
+    }
+    if (!v->binding.global) {
+        chunk.emit(OpCode::SET_LOCAL, 0, v->binding.slot);
+    } else if (v->type == ASTNodeType::VARIABLE_DECLARATION) {
+        chunk.emit(OpCode::DEFINE_GLOBAL, 0, globals.slot(v->name));
+    } else {
+        chunk.emit(OpCode::SET_GLOBAL, 0, globals.slot(v->name));
+    }
+}
+
+void Compiler::compile_function_definition(FunctionDefExpr *s, Chunk &chunk) {
+    auto function = std::make_unique<Function>();
+    function->name = s->name;
+    function->params = s->params;
+    // the caller checks the arguments
+    bool typed = std::any_of(
+        s->param_types.begin(), s->param_types.end(), [](Annotation type) {
+            return type != Annotation::NONE;
+        });
+    if (typed) function->param_types = s->param_types;
+    function->slot = s->slot;
+    function->slots = s->frame_slots;
+    for (const auto &statement : s->statements) {
+        compile_statement(statement.get(), function->chunk);
+    }
+    // falling off the end gifts None
+    function->chunk.emit(OpCode::NONE);
+    function->chunk.emit(OpCode::RETURN);
+
+    program->functions.push_back(std::move(function));
+    size_t at =
+        chunk.emit(OpCode::DEFINE_FUNCTION, 0, program->functions.size() - 1);
+    defined_at.push_back(&chunk == &program->main.chunk ? at : NOT_IN_MAIN);
+}
+
+void Compiler::optimize_chunks(const std::vector<bool> &top_level) {
+    auto &functions = program->functions;
+    Inliner inliner{inlining};
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (top_level[i]) inliner.add_callee(*functions[i], defined_at[i]);
+    }
+    // main last, the definitions are found by where they were in it
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (defined_at[i] != NOT_IN_MAIN) {
+            inliner.inline_into(*functions[i], defined_at[i]);
+        }
+    }
+    inliner.inline_into_main(program->main);
+
+    for (auto &function : functions) {
+        eliminate_redundant_loads(function->chunk, function->slots);
+    }
+    eliminate_redundant_loads(program->main.chunk, program->main.slots);
+}
+
+void Compiler::compile_class_definition(ClassDefinitionExpr *s, Chunk &chunk) {
+    auto class_value = std::make_unique<Class>();
+    class_value->name = s->name;
+    class_value->constructor.name = s->name;
+
+    // literal defaults are evaluated once into the prototype, the
+    // constructor evaluates the others in order into the new instance
+    Chunk &constructor = class_value->constructor.chunk;
+    for (const auto &attr : s->attributes) {
+        if (class_value->shape.find(attr->name) >= 0) {
+            throw Error(Error::NAME_ERROR,
+                        fmt::format("Error: Variable name '{}' already "
+                                    "declared.",
+                                    attr->name));
+        }
+        uint32_t slot = class_value->shape.names.size();
+        class_value->shape.add(attr->name);
+        Expr *value = attr->value.get();
+        if (value->type == ASTNodeType::LITERAL) {
+            class_value->prototype.push_back(
+                copy(memory, ast_cast<LiteralExpr>(value)->value));
+            continue;
+        }
+        class_value->prototype.push_back(Value::none());
+        compile_expr(value, constructor);
+        constructor.emit(OpCode::INIT_ATTR, 0, slot);
+    }
+    if (!constructor.code.empty()) {
+        class_value->constructor.slots = 1;
+        constructor.emit(OpCode::GET_LOCAL, 0, 0);
+        constructor.emit(OpCode::RETURN);
+    }
+    // the methods are defined with the box, before any instance exists
+    for (const auto &method : s->methods) {
+        compile_function_definition(method.get(), chunk);
+        class_value->shape.methods[method->name.substr(s->name.size() + 1)] =
+            method->slot;
+    }
+
+    program->classes.push_back(std::move(class_value));
+    chunk.emit(OpCode::DEFINE_CLASS, 0, program->classes.size() - 1);
+}
+
+void Compiler::compile_object_attr_reassign(ObjectAttrReassignExpr *s,
+                                            Chunk &chunk) {
+    auto dot = ast_cast<DotExpr>(s->head.get());
+    // load everything up to the owner of the last attribute
+    compile_expr(dot->head.get(), chunk);
+    for (size_t i = 0; i + 1 < dot->after.size(); ++i) {
+        compile_dot_step(dot->after[i].get(), chunk);
+    }
+    Expr *last = dot->after.back().get();
+    if (last->type != ASTNodeType::SYMBOL) {
+        throw Error(Error::SYNTAX_ERROR,
+                    "Error: Cannot assign to a method call.");
+    }
+    uint32_t cache = chunk.add_attr_cache(ast_cast<SymbolExpr>(last)->symbol);
+    compile_expr(s->right.get(), chunk);
+    chunk.emit(OpCode::SET_ATTR, 0, cache);
+}
+
+void Compiler::compile_index_assign(IndexAssignExpr *s, Chunk &chunk) {
+    compile_expr(s->head->container.get(), chunk);
+    compile_expr(s->head->index.get(), chunk);
+    compile_expr(s->right.get(), chunk);
+    chunk.emit(OpCode::SET_INDEX);
+}
+
+static void patch_jumps(const std::vector<size_t> &jumps, Chunk &chunk) {
+    for (size_t jump : jumps) {
+        chunk.patch_jump(jump);
+    }
+}
+
+void Compiler::compile_if_statement(IfExpr *s, Chunk &chunk) {
+    std::vector<size_t> exits;
+
+    std::vector<size_t> next;
+    compile_branch(s->condition.get(), false, next, chunk);
+    compile_block(s->statements, chunk);
+    exits.push_back(chunk.emit(OpCode::JUMP));
+    patch_jumps(next, chunk);
+
+    for (const auto &elif : s->elif_statements) {
+        next.clear();
+        compile_branch(elif->condition.get(), false, next, chunk);
+        compile_block(elif->statements, chunk);
+        exits.push_back(chunk.emit(OpCode::JUMP));
+        patch_jumps(next, chunk);
+    }
+
+    if (!s->else_statements.empty()) {
+        compile_block(s->else_statements, chunk);
+    }
+    patch_jumps(exits, chunk);
+}
+
+void Compiler::compile_while_statement(WhileExpr *s, Chunk &chunk) {
+    size_t start = chunk.code.size();
+    std::vector<size_t> exits;
+    compile_branch(s->condition.get(), false, exits, chunk);
+    // TODO: break/continue
+    compile_block(s->statements, chunk);
+    chunk.emit(OpCode::LOOP, 0, start);
+    patch_jumps(exits, chunk);
+}
+
+void Compiler::compile_branch(Expr *condition, bool jump_if,
+                              std::vector<size_t> &jumps, Chunk &chunk) {
+    if (condition->type == ASTNodeType::UNARY) {
+        auto v = ast_cast<UnaryExpr>(condition);
+        if (v->op == TokenType::NOT) {
+            compile_branch(v->unary.get(), !jump_if, jumps, chunk);
+            return;
+        }
+    }
+    if (condition->type != ASTNodeType::BINARY) {
+        compile_expr(condition, chunk);
+        jumps.push_back(chunk.emit(jump_if ? OpCode::JUMP_IF_TRUE
+                                           : OpCode::JUMP_IF_FALSE));
+        return;
+    }
+
+    auto v = ast_cast<BinaryExpr>(condition);
+    OpCode compare;
+    switch (v->op) {
+        case TokenType::AND:
+        case TokenType::OR: {
+            // the right side only runs if the left one didn't decide it
+            bool decides = v->op == TokenType::OR;
+            if (jump_if == decides) {
+                compile_branch(v->left.get(), jump_if, jumps, chunk);
+                compile_branch(v->right.get(), jump_if, jumps, chunk);
+            } else {
+                std::vector<size_t> skip;
+                compile_branch(v->left.get(), decides, skip, chunk);
+                compile_branch(v->right.get(), jump_if, jumps, chunk);
+                patch_jumps(skip, chunk);
+            }
+            return;
+        }
+        case TokenType::LT:
+            compare = OpCode::JUMP_LT;
+            break;
+        case TokenType::GT:
+            compare = OpCode::JUMP_GT;
+            break;
+        case TokenType::LOT:
+            compare = OpCode::JUMP_LOT;
+            break;
+        case TokenType::GOT:
+            compare = OpCode::JUMP_GOT;
+            break;
+        case TokenType::EQUALS:
+            compare = OpCode::JUMP_EQUALS;
+            break;
+        case TokenType::NOT_EQUAL:
+            compare = OpCode::JUMP_NOT_EQUAL;
+            break;
+        default:
+            compile_expr(condition, chunk);
+            jumps.push_back(chunk.emit(jump_if ? OpCode::JUMP_IF_TRUE
+                                               : OpCode::JUMP_IF_FALSE));
+            return;
+    }
+    // the comparison never becomes a bool on the stack
+    compile_expr(v->left.get(), chunk);
+    compile_expr(v->right.get(), chunk);
+    jumps.push_back(chunk.emit(compare, jump_if));
+}
+
+void Compiler::compile_expr(Expr *expr, Chunk &chunk) {
+    switch (expr->type) {
+        case ASTNodeType::LITERAL: {
+            auto literal = ast_cast<LiteralExpr>(expr);
+            uint32_t index = chunk.add_constant(copy(memory, literal->value));
+            chunk.emit(OpCode::CONSTANT, 0, index);
+            return;
+        }
+        case ASTNodeType::LIST: {
+            compile_list(ast_cast<ListExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::SYMBOL: {
+            auto symbol = ast_cast<SymbolExpr>(expr);
+            const Binding &binding = symbol->binding;
+            if (!binding.global) {
+                chunk.emit(OpCode::GET_LOCAL, 0, binding.slot);
+            } else {
+                chunk.emit(
+                    OpCode::GET_GLOBAL, 0, globals.slot(symbol->symbol));
+            }
+            return;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            compile_dot_expr(ast_cast<DotExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::INDEX: {
+            compile_index_expr(ast_cast<IndexExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::BINARY: {
+            compile_binary_expr(ast_cast<BinaryExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::UNARY: {
+            compile_unary_expr(ast_cast<UnaryExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::FUNCTION_CALL: {
+            compile_function_call(ast_cast<CallExpr>(expr), chunk);
+            return;
+        }
+        case ASTNodeType::OBJECT_INSTANTIATION: {
+            const std::string &name =
+                ast_cast<ObjectInstantiationExpr>(expr)->class_name;
+            chunk.emit(OpCode::NEW_OBJECT, 0, chunk.add_class_cache(name));
+            return;
+        }
+        default:
+            throw Error(Error::SYNTAX_ERROR,
+                        "Error: Statement used as an expression.");
+    }
+}
+
+void Compiler::compile_list(ListExpr *s, Chunk &chunk) {
+    for (auto &element : s->elements) {
+        compile_expr(element.get(), chunk);
+    }
+    chunk.emit(OpCode::LIST, s->elements.size());
+}
+
+void Compiler::compile_binary_expr(BinaryExpr *v, Chunk &chunk) {
+    if (v->op == TokenType::AND || v->op == TokenType::OR) {
+        compile_logical_expr(v, chunk);
+        return;
+    }
+    ConcatChain chain;
+    if (find_concat_chain(v, chain)) {
+        compile_concat(chain, chunk);
+        return;
+    }
+    compile_expr(v->left.get(), chunk);
+    if (is_number_type(static_type(v->left.get())) &&
+        is_number_type(static_type(v->right.get()))) {
+        compile_number_op(v, chunk);
+        return;
+    }
+    compile_expr(v->right.get(), chunk);
+    switch (v->op) {
+        case TokenType::PLUS:
+            chunk.emit(OpCode::ADD);
+            return;
+        case TokenType::MINUS:
+            chunk.emit(OpCode::SUB);
+            return;
+        case TokenType::MUL:
+            chunk.emit(OpCode::MUL);
+            return;
+        case TokenType::DIV:
+            chunk.emit(OpCode::DIV);
+            return;
+        case TokenType::LT:
+            chunk.emit(OpCode::LT);
+            return;
+        case TokenType::GT:
+            chunk.emit(OpCode::GT);
+            return;
+        case TokenType::LOT:
+            chunk.emit(OpCode::LOT);
+            return;
+        case TokenType::GOT:
+            chunk.emit(OpCode::GOT);
+            return;
+        case TokenType::EQUALS:
+            chunk.emit(OpCode::EQUALS);
+            return;
+        case TokenType::NOT_EQUAL:
+            chunk.emit(OpCode::NOT_EQUAL);
+            return;
+        default:
+            throw Error(Error::SYNTAX_ERROR,
+                        fmt::format("Error: Invalid operation '{}'.", v->op));
+    }
+}
+
+// the operator of a quickened or fused instruction, ADD + index
+static uint16_t operator_index(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS:
+            return 0;
+        case TokenType::MINUS:
+            return 1;
+        case TokenType::MUL:
+            return 2;
+        case TokenType::DIV:
+            return 3;
+        case TokenType::LT:
+            return 4;
+        case TokenType::GT:
+            return 5;
+        case TokenType::LOT:
+            return 6;
+        case TokenType::GOT:
+            return 7;
+        case TokenType::EQUALS:
+            return 8;
+        case TokenType::NOT_EQUAL:
+            return 9;
+        default:
+            throw Error(Error::SYNTAX_ERROR,
+                        fmt::format("Error: Invalid operation '{}'.", op));
+    }
+}
+
+void Compiler::compile_number_op(BinaryExpr *v, Chunk &chunk) {
+    // the left side is already on the stack
+    uint16_t op = operator_index(v->op);
+    Expr *right = v->right.get();
+    if (right->type == ASTNodeType::SYMBOL &&
+        !ast_cast<SymbolExpr>(right)->binding.global) {
+        chunk.emit(
+            OpCode::NUM_LOCAL, op, ast_cast<SymbolExpr>(right)->binding.slot);
+        return;
+    }
+    if (right->type == ASTNodeType::LITERAL) {
+        Value value = ast_cast<LiteralExpr>(right)->value;
+        chunk.emit(OpCode::NUM_CONST, op, chunk.add_constant(value));
+        return;
+    }
+    // starts out quickened instead of having to warm up
+    compile_expr(right, chunk);
+    chunk.emit((OpCode)((int)OpCode::ADD_NUM + op));
+}
+
+void Compiler::compile_logical_expr(BinaryExpr *v, Chunk &chunk) {
+    // short-circuits as a branch, then pushes the outcome
+    std::vector<size_t> is_false;
+    compile_branch(v, false, is_false, chunk);
+    chunk.emit(OpCode::CONSTANT, 0, chunk.add_constant(Value::boolean(true)));
+    size_t exit = chunk.emit(OpCode::JUMP);
+    patch_jumps(is_false, chunk);
+    chunk.emit(OpCode::CONSTANT, 0, chunk.add_constant(Value::boolean(false)));
+    chunk.patch_jump(exit);
+}
+
+void Compiler::compile_concat(const ConcatChain &chain, Chunk &chunk) {
+    compile_expr(chain.prefix, chunk);
+    compile_expr(chain.pieces[0], chunk);
+    chunk.emit(OpCode::CONCAT, 0, chain.size);
+    for (size_t i = 1; i < chain.pieces.size(); ++i) {
+        compile_expr(chain.pieces[i], chunk);
+        // nothing else holds the new string
+        chunk.emit(OpCode::ADD_IN_PLACE);
+    }
+}
+
+void Compiler::compile_unary_expr(UnaryExpr *v, Chunk &chunk) {
+    compile_expr(v->unary.get(), chunk);
+    if (v->op == TokenType::MINUS) {
+        chunk.emit(OpCode::NEGATE);
+    } else {
+        chunk.emit(OpCode::NOT);
+    }
+}
+
+void Compiler::compile_function_call(CallExpr *s, Chunk &chunk, OpCode op) {
+    for (auto &param : s->params) {
+        compile_expr(param.get(), chunk);
+    }
+    if (s->target.kind == Callee::NATIVE) op = OpCode::CALL_NATIVE;
+    chunk.emit(op, s->params.size(), s->target.index);
+}
+
+void Compiler::compile_dot_expr(DotExpr *s, Chunk &chunk) {
+    compile_expr(s->head.get(), chunk);
+    for (auto &after : s->after) {
+        compile_dot_step(after.get(), chunk);
+    }
+}
+
+void Compiler::compile_dot_step(Expr *after, Chunk &chunk) {
+    if (after->type == ASTNodeType::SYMBOL) {
+        const std::string &name = ast_cast<SymbolExpr>(after)->symbol;
+        chunk.emit(OpCode::GET_ATTR, 0, chunk.add_attr_cache(name));
+        return;
+    }
+    if (after->type != ASTNodeType::FUNCTION_CALL) {
+        throw Error(Error::SYNTAX_ERROR,
+                    "Invalid function call dot expression.");
+    }
+    // the instance is already on the stack, the arguments go above it
+    auto call = ast_cast<CallExpr>(after);
+    for (auto &param : call->params) {
+        compile_expr(param.get(), chunk);
+    }
+    chunk.emit(OpCode::CALL_METHOD,
+               call->params.size(),
+               chunk.add_method_cache(call->callee->symbol));
+}
+
+void Compiler::compile_index_expr(IndexExpr *s, Chunk &chunk) {
+    compile_expr(s->container.get(), chunk);
+    compile_expr(s->index.get(), chunk);
+    chunk.emit(OpCode::GET_INDEX);
+}
@@ -0,0 +1,88 @@
+#ifndef COMPILER_COMPILER_HPP
+#define COMPILER_COMPILER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.hpp"
+#include "compiler/bytecode.hpp"
+#include "compiler/inliner.hpp"
+#include "compiler/resolver.hpp"
+#include "runtime/memory.hpp"
+#include "util/error.hpp"
+#include "util/util.hpp"
+
+// `a + "b" + c + d`: a chain of +s with a string literal in it. The sum up
+// to the literal is computed as usual, adding the literal makes a new string
+// with room for the whole chain and every later piece is appended to it in
+// place as soon as it is evaluated, so no prefix is copied again
+struct ConcatChain {
+    // the sum before the literal, or the first piece
+    Expr *prefix = nullptr;
+    // the first is added to prefix making the string, the rest are appended
+    std::vector<Expr *> pieces;
+    // the literals' characters and a guess for every other piece
+    uint32_t size = 0;
+};
+// false unless v is the last + of such a chain of three pieces or more
+bool find_concat_chain(BinaryExpr *v, ConcatChain &chain);
+
+// lowers the resolved AST from Parser::parse() into bytecode for the
+// Interpreter
+class Compiler {
+  public:
+    Compiler(Memory &memory, GlobalTable &globals,
+             const InlineOptions &inlining = {});
+    // main_slots is the main chunk's frame size from the Resolver
+    uptr<Program> compile(const std::vector<uptr<Statement>> &ast,
+                          uint32_t main_slots);
+
+  private:
+    // statements
+    void compile_statement(Statement *statement, Chunk &chunk);
+    void compile_block(const std::vector<uptr<Statement>> &statements,
+                       Chunk &chunk);
+    void compile_variable_declaration(VariableDeclaration *v, Chunk &chunk);
+    void compile_function_definition(FunctionDefExpr *s, Chunk &chunk);
+    void compile_class_definition(ClassDefinitionExpr *s, Chunk &chunk);
+    void compile_object_attr_reassign(ObjectAttrReassignExpr *s,
+                                      Chunk &chunk);
+    void compile_index_assign(IndexAssignExpr *s, Chunk &chunk);
+    void compile_if_statement(IfExpr *s, Chunk &chunk);
+    void compile_while_statement(WhileExpr *s, Chunk &chunk);
+    // emits code that jumps when condition evaluates to jump_if and falls
+    // through otherwise, the jumps are added to be patched by the caller
+    void compile_branch(Expr *condition, bool jump_if,
+                        std::vector<size_t> &jumps, Chunk &chunk);
+
+    // expressions
+    void compile_expr(Expr *expr, Chunk &chunk);
+    void compile_list(ListExpr *s, Chunk &chunk);
+    void compile_binary_expr(BinaryExpr *v, Chunk &chunk);
+    void compile_logical_expr(BinaryExpr *v, Chunk &chunk);
+    void compile_concat(const ConcatChain &chain, Chunk &chunk);
+    // both sides are known to be numbers
+    void compile_number_op(BinaryExpr *v, Chunk &chunk);
+    void compile_unary_expr(UnaryExpr *v, Chunk &chunk);
+    // op is CALL or TAIL_CALL for a confection
+    void compile_function_call(CallExpr *s, Chunk &chunk,
+                               OpCode op = OpCode::CALL);
+    void compile_dot_expr(DotExpr *s, Chunk &chunk);
+    // one attribute load or method call on the object on top of the stack
+    void compile_dot_step(Expr *after, Chunk &chunk);
+    void compile_index_expr(IndexExpr *s, Chunk &chunk);
+
+    // inlines calls, then drops repeated attribute loads, in every chunk
+    void optimize_chunks(const std::vector<bool> &top_level);
+
+    Memory &memory;
+    GlobalTable &globals;
+    InlineOptions inlining;
+    Program *program = nullptr;
+    // the index of the DEFINE_FUNCTION of each of program->functions in the
+    // main chunk, NOT_IN_MAIN if another confection defines it
+    std::vector<size_t> defined_at;
+    static constexpr size_t NOT_IN_MAIN = SIZE_MAX;
+};
+
+#endif // COMPILER_COMPILER_HPP
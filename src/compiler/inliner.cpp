@@ -0,0 +1,143 @@
+#include "inliner.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <vector>
+
+// appends callee to code with its frame moved up to region, a gift jumps
+// to whatever follows the copy
+static void splice(const Function &callee, uint32_t region, Chunk &chunk,
+                   std::vector<Instruction> &code) {
+    const Chunk &body = callee.chunk;
+    // the arguments are on the stack, the last one on top
+    for (size_t i = callee.params.size(); i-- > 0;) {
+        // the check CALL would have made
+        if (!callee.param_types.empty() &&
+            callee.param_types[i] != Annotation::NONE) {
+            code.push_back({OpCode::CHECK_TYPE,
+                            (uint16_t)callee.param_types[i],
+                            chunk.add_name(callee.params[i])});
+        }
+        code.push_back({OpCode::SET_LOCAL, 0, (uint32_t)(region + i)});
+    }
+    size_t start = code.size();
+    // the final RETURN is dropped, the copy just falls through
+    uint32_t end = start + body.code.size() - 1;
+    for (size_t i = 0; i + 1 < body.code.size(); ++i) {
+        Instruction inst = body.code[i];
+        switch (inst.op) {
+            case OpCode::GET_LOCAL:
+            case OpCode::SET_LOCAL:
+            case OpCode::TEE_LOCAL:
+            case OpCode::SET_LOCAL_ATTR:
+            case OpCode::NUM_LOCAL:
+                inst.b += region;
+                break;
+            case OpCode::CONSTANT:
+            case OpCode::NUM_CONST:
+                inst.b = chunk.add_constant(body.constants[inst.b]);
+                break;
+            case OpCode::GET_ATTR:
+            case OpCode::SET_ATTR:
+                inst.b = chunk.add_attr_cache(
+                    body.names[body.attr_caches[inst.b].name]);
+                break;
+            case OpCode::NEW_OBJECT:
+                inst.b = chunk.add_class_cache(
+                    body.names[body.class_caches[inst.b].name]);
+                break;
+            case OpCode::CHECK_TYPE:
+                inst.b = chunk.add_name(body.names[inst.b]);
+                break;
+            case OpCode::RETURN:
+                inst = {OpCode::JUMP, 0, end};
+                break;
+            default:
+                if (is_jump(inst.op)) inst.b += start;
+                break;
+        }
+        code.push_back(inst);
+    }
+}
+
+Inliner::Inliner(const InlineOptions &options) : options(options) {}
+
+void Inliner::add_callee(const Function &function, size_t defined_at) {
+    if (!options.enabled || function.chunk.code.size() > options.max_size) {
+        return;
+    }
+    for (const Instruction &inst : function.chunk.code) {
+        switch (inst.op) {
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL:
+            // a method may be the caller itself
+            case OpCode::CALL_METHOD:
+            case OpCode::DEFINE_FUNCTION:
+            case OpCode::DEFINE_CLASS:
+                return;
+            default:
+                break;
+        }
+    }
+    callees[function.slot] = {&function, defined_at};
+}
+
+void Inliner::inline_into(Function &caller, size_t defined_at) {
+    inline_calls(caller, defined_at, false);
+}
+
+void Inliner::inline_into_main(Function &main) {
+    inline_calls(main, 0, true);
+}
+
+void Inliner::inline_calls(Function &caller, size_t defined_at,
+                           bool is_main) {
+    if (callees.empty()) return;
+    Chunk &chunk = caller.chunk;
+    std::vector<Instruction> &code = chunk.code;
+
+    // copies never overlap, a callee can't contain another one, so they all
+    // share one region of the frame
+    uint32_t region = caller.slots;
+    uint32_t used = 0;
+    uint32_t spent = 0;
+    std::vector<Instruction> result;
+    result.reserve(code.size());
+    std::vector<uint32_t> moved(code.size() + 1);
+    // the caller's own jumps, the copies' are already in place
+    std::vector<size_t> jumps;
+    for (size_t i = 0; i < code.size(); ++i) {
+        moved[i] = result.size();
+        const Instruction &inst = code[i];
+        if (inst.op == OpCode::CALL) {
+            auto it = callees.find(inst.b);
+            // main only defines the callee when it gets to defined_at
+            bool defined = it != callees.end() &&
+                           it->second.defined_at < (is_main ? i : defined_at);
+            if (defined) {
+                const Function &callee = *it->second.function;
+                uint32_t size = callee.chunk.code.size();
+                if (spent + size <= options.budget) {
+                    spent += size;
+                    used = std::max(used, callee.slots);
+                    splice(callee, region, chunk, result);
+                    if (options.trace) {
+                        fmt::println("inlined {} into {} ({} instructions)",
+                                     callee.name, caller.name, size);
+                    }
+                    continue;
+                }
+            }
+        }
+        if (is_jump(inst.op)) jumps.push_back(result.size());
+        result.push_back(inst);
+    }
+    if (spent == 0) return;
+    moved[code.size()] = result.size();
+    for (size_t jump : jumps) {
+        result[jump].b = moved[result[jump].b];
+    }
+    code = std::move(result);
+    caller.slots = region + used;
+}
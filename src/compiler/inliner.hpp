@@ -0,0 +1,51 @@
+#ifndef COMPILER_INLINER_HPP
+#define COMPILER_INLINER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "compiler/bytecode.hpp"
+
+struct InlineOptions {
+    bool enabled = true;
+    // confections longer than this many instructions are always called
+    uint32_t max_size = 48;
+    // instructions inlining may add to one chunk, later sites stay calls
+    uint32_t budget = 512;
+    // print every call site that was inlined
+    bool trace = false;
+};
+
+// copies small confections into the chunks that call them: the arguments
+// are stored into a spare region at the end of the caller's frame, the
+// callee's locals are moved up into it and a gift jumps past the copy
+// with its value on the stack. Only leaf confections (no calls to other
+// confections, so nothing recursive) defined by a top-level statement are
+// inlined, and only where their DEFINE_FUNCTION is certain to have run
+class Inliner {
+  public:
+    Inliner(const InlineOptions &options);
+
+    // function is defined by the top-level instruction `defined_at` of the
+    // main chunk
+    void add_callee(const Function &function, size_t defined_at);
+    // a confection only runs after main got to its DEFINE_FUNCTION at
+    // `defined_at`
+    void inline_into(Function &caller, size_t defined_at);
+    // in main a callee can be used after its definition
+    void inline_into_main(Function &main);
+
+  private:
+    void inline_calls(Function &caller, size_t defined_at, bool is_main);
+
+    struct Callee {
+        const Function *function;
+        size_t defined_at;
+    };
+    // by function table slot
+    std::unordered_map<uint32_t, Callee> callees;
+    const InlineOptions &options;
+};
+
+#endif // COMPILER_INLINER_HPP
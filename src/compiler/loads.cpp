@@ -0,0 +1,158 @@
+#include "loads.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// GET_LOCAL/GET_GLOBAL followed by one or more GET_ATTRs
+struct Load {
+    OpCode head_op;
+    uint32_t head;
+    // chunk.names indices of the attributes, in order
+    std::vector<uint32_t> names;
+    size_t at;
+    size_t length;
+    // loads are only reused within the region they were made in
+    size_t region;
+    // the earlier load this one repeats, -1 if none
+    int64_t repeats = -1;
+    bool reused = false;
+    uint32_t slot = 0;
+};
+
+bool same_chain(const Load &a, const Load &b) {
+    return a.head_op == b.head_op && a.head == b.head && a.names == b.names;
+}
+
+} // namespace
+
+void eliminate_redundant_loads(Chunk &chunk, uint32_t &frame_slots) {
+    std::vector<Instruction> &code = chunk.code;
+    std::vector<bool> targets(code.size() + 1, false);
+    for (const Instruction &inst : code) {
+        if (is_jump(inst.op)) targets[inst.b] = true;
+    }
+
+    // find every chain and the earlier chain it repeats, if any
+    std::vector<Load> loads;
+    std::vector<size_t> available;
+    size_t region = 0;
+    auto forget = [&](auto predicate) {
+        std::erase_if(available,
+                      [&](size_t index) { return predicate(loads[index]); });
+    };
+    auto clear = [&]() {
+        available.clear();
+        region++;
+    };
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (targets[i]) clear();
+        const Instruction &inst = code[i];
+        if (inst.op == OpCode::GET_LOCAL || inst.op == OpCode::GET_GLOBAL) {
+            size_t end = i + 1;
+            while (end < code.size() && code[end].op == OpCode::GET_ATTR &&
+                   !targets[end]) {
+                end++;
+            }
+            if (end > i + 1) {
+                Load load{inst.op, inst.b, {}, i, end - i, region};
+                for (size_t j = i + 1; j < end; ++j) {
+                    load.names.push_back(chunk.attr_caches[code[j].b].name);
+                }
+                for (size_t index : available) {
+                    if (same_chain(loads[index], load)) load.repeats = index;
+                }
+                if (load.repeats >= 0) {
+                    loads[load.repeats].reused = true;
+                } else {
+                    available.push_back(loads.size());
+                }
+                loads.push_back(std::move(load));
+                i = end - 1;
+                continue;
+            }
+        }
+        switch (inst.op) {
+            case OpCode::SET_LOCAL:
+            case OpCode::TEE_LOCAL:
+            case OpCode::SET_LOCAL_ATTR:
+                forget([&](const Load &load) {
+                    return load.head_op == OpCode::GET_LOCAL &&
+                           load.head == inst.b;
+                });
+                break;
+            case OpCode::SET_GLOBAL:
+            case OpCode::DEFINE_GLOBAL:
+                forget([&](const Load &load) {
+                    return load.head_op == OpCode::GET_GLOBAL &&
+                           load.head == inst.b;
+                });
+                break;
+            case OpCode::SET_ATTR: {
+                // any object may be the one written, so every chain going
+                // through an attribute of that name is stale
+                uint32_t name = chunk.attr_caches[inst.b].name;
+                forget([&](const Load &load) {
+                    return std::find(load.names.begin(), load.names.end(),
+                                     name) != load.names.end();
+                });
+                break;
+            }
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL:
+            case OpCode::CALL_METHOD:
+            case OpCode::NEW_OBJECT:
+                // confections and constructors may write any variable or
+                // attribute, natives can't
+            case OpCode::JUMP:
+            case OpCode::LOOP:
+            case OpCode::RETURN:
+                clear();
+                break;
+            default:
+                break;
+        }
+    }
+
+    // copies in different regions never live at the same time
+    std::vector<uint32_t> used(region + 1, 0);
+    uint32_t extra = 0;
+    for (Load &load : loads) {
+        if (!load.reused) continue;
+        load.slot = frame_slots + used[load.region]++;
+        extra = std::max(extra, used[load.region]);
+    }
+    if (extra == 0) return;
+    frame_slots += extra;
+
+    std::vector<Instruction> result;
+    result.reserve(code.size());
+    std::vector<uint32_t> moved(code.size() + 1);
+    size_t next = 0;
+    for (size_t i = 0; i < code.size(); ++i) {
+        moved[i] = result.size();
+        if (next < loads.size() && loads[next].at == i) {
+            const Load &load = loads[next++];
+            if (load.repeats >= 0) {
+                const Load &first = loads[load.repeats];
+                result.push_back({OpCode::GET_LOCAL, 0, first.slot});
+            } else {
+                result.insert(result.end(), code.begin() + i,
+                              code.begin() + i + load.length);
+                if (load.reused) {
+                    result.push_back({OpCode::TEE_LOCAL, 0, load.slot});
+                }
+            }
+            // nothing jumps into the middle of a chain
+            i += load.length - 1;
+            continue;
+        }
+        result.push_back(code[i]);
+    }
+    moved[code.size()] = result.size();
+    for (Instruction &inst : result) {
+        if (is_jump(inst.op)) inst.b = moved[inst.b];
+    }
+    code = std::move(result);
+}
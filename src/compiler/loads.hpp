@@ -0,0 +1,16 @@
+#ifndef COMPILER_LOADS_HPP
+#define COMPILER_LOADS_HPP
+
+#include <cstdint>
+
+#include "compiler/bytecode.hpp"
+
+// redundant attribute load elimination: a chain like `a.x` loaded again
+// before anything could have changed it reads a copy kept in a spare frame
+// slot instead. Loads are only reused along straight-line code, a jump
+// target, a write to the head variable, a SET_ATTR of any name in the chain
+// or a call to a confection forgets them. frame_slots grows by the slots the
+// copies need
+void eliminate_redundant_loads(Chunk &chunk, uint32_t &frame_slots);
+
+#endif // COMPILER_LOADS_HPP
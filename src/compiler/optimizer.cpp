@@ -0,0 +1,960 @@
+#include "optimizer.hpp"
+
+#include <algorithm>
+
+#include "runtime/operators.hpp"
+#include "token.hpp"
+
+static bool is_immediate(Expr *expr) {
+    if (expr->type != ASTNodeType::LITERAL) return false;
+    Value value = ast_cast<LiteralExpr>(expr)->value;
+    return value.is_number() || value.is_bool();
+}
+
+static bool is_bool_literal(Expr *expr, bool b) {
+    if (expr->type != ASTNodeType::LITERAL) return false;
+    Value value = ast_cast<LiteralExpr>(expr)->value;
+    return value.is_bool() && value.as_bool() == b;
+}
+
+static uptr<Expr> make_literal(Value value) {
+    auto literal = std::make_unique<LiteralExpr>();
+    literal->value = value;
+    return literal;
+}
+
+static uptr<Statement> make_block(std::vector<uptr<Statement>> statements) {
+    auto block = std::make_unique<BlockExpr>();
+    block->statements = std::move(statements);
+    return block;
+}
+
+// calls f on node and everything under it
+template <typename F>
+static void visit(ASTNode *node, const F &f) {
+    f(node);
+    auto all = [&](const auto &nodes) {
+        for (const auto &n : nodes) visit(n.get(), f);
+    };
+    switch (node->type) {
+        case ASTNodeType::VARIABLE_DECLARATION:
+        case ASTNodeType::VARIABLE_REASSIGN:
+            visit(ast_cast<VariableDeclaration>(node)->value.get(), f);
+            return;
+        case ASTNodeType::IF_STATEMENT: {
+            auto s = ast_cast<IfExpr>(node);
+            visit(s->condition.get(), f);
+            all(s->statements);
+            for (const auto &elif : s->elif_statements) {
+                visit(elif->condition.get(), f);
+                all(elif->statements);
+            }
+            all(s->else_statements);
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            auto s = ast_cast<WhileExpr>(node);
+            visit(s->condition.get(), f);
+            all(s->statements);
+            return;
+        }
+        case ASTNodeType::FUNCTION_CALL:
+            all(ast_cast<CallExpr>(node)->params);
+            return;
+        case ASTNodeType::FUNCTION_DEFINITION:
+            all(ast_cast<FunctionDefExpr>(node)->statements);
+            return;
+        case ASTNodeType::RETURN_STATEMENT:
+            visit(ast_cast<ReturnExpr>(node)->content.get(), f);
+            return;
+        case ASTNodeType::CLASS_DEFINITION: {
+            auto s = ast_cast<ClassDefinitionExpr>(node);
+            all(s->attributes);
+            all(s->methods);
+            return;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            auto s = ast_cast<ObjectAttrReassignExpr>(node);
+            visit(s->head.get(), f);
+            visit(s->right.get(), f);
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            auto s = ast_cast<IndexAssignExpr>(node);
+            visit(s->head.get(), f);
+            visit(s->right.get(), f);
+            return;
+        }
+        case ASTNodeType::BLOCK:
+            all(ast_cast<BlockExpr>(node)->statements);
+            return;
+        case ASTNodeType::LIST:
+            all(ast_cast<ListExpr>(node)->elements);
+            return;
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(node);
+            visit(v->left.get(), f);
+            visit(v->right.get(), f);
+            return;
+        }
+        case ASTNodeType::UNARY:
+            visit(ast_cast<UnaryExpr>(node)->unary.get(), f);
+            return;
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(node);
+            visit(v->head.get(), f);
+            all(v->after);
+            return;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(node);
+            visit(v->container.get(), f);
+            visit(v->index.get(), f);
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+static bool has_call(ASTNode *node) {
+    bool found = false;
+    visit(node, [&](ASTNode *n) {
+        found |= n->type == ASTNodeType::FUNCTION_CALL ||
+                 n->type == ASTNodeType::OBJECT_INSTANTIATION;
+    });
+    return found;
+}
+
+// a copy of a condition made of symbols, dots, literals and operators,
+// nullptr for anything else
+static uptr<Expr> clone(Expr *expr) {
+    switch (expr->type) {
+        case ASTNodeType::LITERAL:
+            // a string literal's object stays owned by the original
+            return make_literal(ast_cast<LiteralExpr>(expr)->value);
+        case ASTNodeType::SYMBOL:
+            return std::make_unique<SymbolExpr>(
+                ast_cast<SymbolExpr>(expr)->symbol);
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(expr);
+            auto copy = std::make_unique<DotExpr>();
+            copy->head = clone(v->head.get());
+            if (copy->head == nullptr) return nullptr;
+            for (const auto &after : v->after) {
+                copy->after.push_back(clone(after.get()));
+                // a method call
+                if (copy->after.back() == nullptr) return nullptr;
+            }
+            return copy;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            auto left = clone(v->left.get());
+            auto right = clone(v->right.get());
+            if (left == nullptr || right == nullptr) return nullptr;
+            auto copy = std::make_unique<BinaryExpr>();
+            copy->left = std::move(left);
+            copy->right = std::move(right);
+            copy->op = v->op;
+            return copy;
+        }
+        case ASTNodeType::UNARY: {
+            auto v = ast_cast<UnaryExpr>(expr);
+            auto unary = clone(v->unary.get());
+            if (unary == nullptr) return nullptr;
+            auto copy = std::make_unique<UnaryExpr>();
+            copy->unary = std::move(unary);
+            copy->op = v->op;
+            return copy;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// true if expr can only produce a number (or fail), a + b may also make a
+// new string every time it runs, which must not be shared
+static bool is_numeric(Expr *expr) {
+    switch (expr->type) {
+        case ASTNodeType::LITERAL:
+            return ast_cast<LiteralExpr>(expr)->value.is_number();
+        case ASTNodeType::UNARY:
+            return ast_cast<UnaryExpr>(expr)->op == TokenType::MINUS;
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            if (v->op != TokenType::PLUS) {
+                return v->op == TokenType::MINUS || v->op == TokenType::MUL ||
+                       v->op == TokenType::DIV || v->op == TokenType::MOD;
+            }
+            return is_numeric(v->left.get()) && is_numeric(v->right.get());
+        }
+        default:
+            return false;
+    }
+}
+
+// what the body of a loop may change on every iteration
+struct LoopEffects {
+    std::unordered_set<std::string> variables;
+    std::unordered_set<std::string> attributes;
+    // confection calls and constructors may change anything
+    bool calls = false;
+};
+
+static bool is_invariant(Expr *expr, const LoopEffects &effects) {
+    switch (expr->type) {
+        case ASTNodeType::LITERAL:
+            return true;
+        case ASTNodeType::SYMBOL:
+            return !effects.variables.contains(
+                ast_cast<SymbolExpr>(expr)->symbol);
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(expr);
+            if (!is_invariant(v->head.get(), effects)) return false;
+            for (const auto &after : v->after) {
+                if (after->type != ASTNodeType::SYMBOL ||
+                    effects.attributes.contains(
+                        ast_cast<SymbolExpr>(after.get())->symbol)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            if (v->op == TokenType::PLUS && !is_numeric(v)) return false;
+            return is_invariant(v->left.get(), effects) &&
+                   is_invariant(v->right.get(), effects);
+        }
+        case ASTNodeType::UNARY:
+            return is_invariant(ast_cast<UnaryExpr>(expr)->unary.get(),
+                                effects);
+        default:
+            // lists are new every time they are evaluated
+            return false;
+    }
+}
+
+static bool is_symbol(Expr *expr, const std::string &name) {
+    return expr->type == ASTNodeType::SYMBOL &&
+           ast_cast<SymbolExpr>(expr)->symbol == name;
+}
+
+// a box whose instances can live in locals: every default is a literal, so
+// making one can't fail or run anything
+static bool is_scalar_box(ClassDefinitionExpr *s) {
+    if (s->attributes.empty()) return false;
+    for (size_t i = 0; i < s->attributes.size(); ++i) {
+        if (s->attributes[i]->value->type != ASTNodeType::LITERAL) {
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (s->attributes[j]->name == s->attributes[i]->name) return false;
+        }
+    }
+    return true;
+}
+
+static bool has_attribute(ClassDefinitionExpr *box, Expr *after) {
+    if (after->type != ASTNodeType::SYMBOL) return false;
+    const std::string &name = ast_cast<SymbolExpr>(after)->symbol;
+    return std::any_of(
+        box->attributes.begin(), box->attributes.end(), [&](const auto &a) {
+            return a->name == name;
+        });
+}
+
+// true if the instance of box in the variable name is only read and written
+// through its attributes by statements[from...], it then never escapes: it
+// isn't passed, gifted, stored anywhere or compared
+static bool is_replaceable(const std::string &name, ClassDefinitionExpr *box,
+                           const std::vector<uptr<Statement>> &statements,
+                           size_t from) {
+    size_t symbols = 0;
+    size_t attributes = 0;
+    bool reassigned = false;
+    for (size_t i = from; i < statements.size(); ++i) {
+        visit(statements[i].get(), [&](ASTNode *n) {
+            switch (n->type) {
+                case ASTNodeType::SYMBOL:
+                    symbols += ast_cast<SymbolExpr>(n)->symbol == name;
+                    break;
+                case ASTNodeType::DOT_SYMBOL: {
+                    auto v = ast_cast<DotExpr>(n);
+                    // the names after a dot are attributes, not variables
+                    for (const auto &after : v->after) {
+                        attributes += is_symbol(after.get(), name);
+                    }
+                    if (is_symbol(v->head.get(), name) &&
+                        has_attribute(box, v->after.front().get())) {
+                        attributes++;
+                    }
+                    break;
+                }
+                case ASTNodeType::VARIABLE_REASSIGN:
+                    reassigned |=
+                        ast_cast<VariableDeclaration>(n)->name == name;
+                    break;
+                default:
+                    break;
+            }
+        });
+    }
+    return !reassigned && symbols == attributes;
+}
+
+// the local holding one attribute of the instance in the variable name, the
+// dot keeps it apart from every name a script can declare
+static std::string scalar_name(const std::string &name, Expr *attribute) {
+    return name + "." + ast_cast<SymbolExpr>(attribute)->symbol;
+}
+
+// rewrites name.attribute into the attribute's local
+static void replace_attributes(uptr<Expr> &expr, const std::string &name) {
+    switch (expr->type) {
+        case ASTNodeType::LIST:
+            for (auto &element : ast_cast<ListExpr>(expr.get())->elements) {
+                replace_attributes(element, name);
+            }
+            return;
+        case ASTNodeType::FUNCTION_CALL:
+            for (auto &param : ast_cast<CallExpr>(expr.get())->params) {
+                replace_attributes(param, name);
+            }
+            return;
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr.get());
+            replace_attributes(v->left, name);
+            replace_attributes(v->right, name);
+            return;
+        }
+        case ASTNodeType::UNARY:
+            replace_attributes(ast_cast<UnaryExpr>(expr.get())->unary, name);
+            return;
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(expr.get());
+            replace_attributes(v->container, name);
+            replace_attributes(v->index, name);
+            return;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(expr.get());
+            for (auto &after : v->after) {
+                if (after->type != ASTNodeType::FUNCTION_CALL) continue;
+                for (auto &param : ast_cast<CallExpr>(after.get())->params) {
+                    replace_attributes(param, name);
+                }
+            }
+            if (!is_symbol(v->head.get(), name)) {
+                replace_attributes(v->head, name);
+                return;
+            }
+            auto local = std::make_unique<SymbolExpr>(
+                scalar_name(name, v->after.front().get()));
+            if (v->after.size() == 1) {
+                expr = std::move(local);
+                return;
+            }
+            // the attribute holds an object of its own
+            v->after.erase(v->after.begin());
+            v->head = std::move(local);
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+static void replace_attributes(std::vector<uptr<Statement>> &statements,
+                               size_t from, const std::string &name);
+
+static void replace_attributes(uptr<Statement> &statement,
+                               const std::string &name) {
+    switch (statement->type) {
+        case ASTNodeType::VARIABLE_DECLARATION:
+        case ASTNodeType::VARIABLE_REASSIGN:
+            replace_attributes(
+                ast_cast<VariableDeclaration>(statement.get())->value, name);
+            return;
+        case ASTNodeType::IF_STATEMENT: {
+            auto s = ast_cast<IfExpr>(statement.get());
+            replace_attributes(s->condition, name);
+            replace_attributes(s->statements, 0, name);
+            for (auto &elif : s->elif_statements) {
+                replace_attributes(elif->condition, name);
+                replace_attributes(elif->statements, 0, name);
+            }
+            replace_attributes(s->else_statements, 0, name);
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            auto s = ast_cast<WhileExpr>(statement.get());
+            replace_attributes(s->condition, name);
+            replace_attributes(s->statements, 0, name);
+            return;
+        }
+        case ASTNodeType::BLOCK:
+            replace_attributes(
+                ast_cast<BlockExpr>(statement.get())->statements, 0, name);
+            return;
+        case ASTNodeType::RETURN_STATEMENT:
+            replace_attributes(
+                ast_cast<ReturnExpr>(statement.get())->content, name);
+            return;
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            auto s = ast_cast<ObjectAttrReassignExpr>(statement.get());
+            replace_attributes(s->right, name);
+            auto dot = ast_cast<DotExpr>(s->head.get());
+            if (!is_symbol(dot->head.get(), name) || dot->after.size() > 1) {
+                replace_attributes(s->head, name);
+                return;
+            }
+            auto store = std::make_unique<VariableDeclaration>();
+            store->type = ASTNodeType::VARIABLE_REASSIGN;
+            store->name = scalar_name(name, dot->after.front().get());
+            store->value = std::move(s->right);
+            store->attribute = true;
+            statement = std::move(store);
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            auto s = ast_cast<IndexAssignExpr>(statement.get());
+            replace_attributes(s->head->container, name);
+            replace_attributes(s->head->index, name);
+            replace_attributes(s->right, name);
+            return;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION:
+        case ASTNodeType::CLASS_DEFINITION:
+            // the variables of a confection aren't visible in the ones it
+            // defines
+            return;
+        default: {
+            uptr<Expr> expr{ast_cast<Expr>(statement.release())};
+            replace_attributes(expr, name);
+            statement = std::move(expr);
+            return;
+        }
+    }
+}
+
+static void replace_attributes(std::vector<uptr<Statement>> &statements,
+                               size_t from, const std::string &name) {
+    for (size_t i = from; i < statements.size(); ++i) {
+        replace_attributes(statements[i], name);
+    }
+}
+
+using ScalarBoxes = std::unordered_map<std::string, ClassDefinitionExpr *>;
+
+static void replace_scalars(FunctionDefExpr *function,
+                            const ScalarBoxes &boxes);
+
+static void replace_scalars(std::vector<uptr<Statement>> &statements,
+                            const std::unordered_map<std::string, int> &lets,
+                            const ScalarBoxes &boxes) {
+    for (size_t i = 0; i < statements.size(); ++i) {
+        Statement *statement = statements[i].get();
+        switch (statement->type) {
+            case ASTNodeType::IF_STATEMENT: {
+                auto s = ast_cast<IfExpr>(statement);
+                replace_scalars(s->statements, lets, boxes);
+                for (auto &elif : s->elif_statements) {
+                    replace_scalars(elif->statements, lets, boxes);
+                }
+                replace_scalars(s->else_statements, lets, boxes);
+                continue;
+            }
+            case ASTNodeType::WHILE_STATEMENT:
+                replace_scalars(
+                    ast_cast<WhileExpr>(statement)->statements, lets, boxes);
+                continue;
+            case ASTNodeType::BLOCK:
+                replace_scalars(
+                    ast_cast<BlockExpr>(statement)->statements, lets, boxes);
+                continue;
+            case ASTNodeType::FUNCTION_DEFINITION:
+                replace_scalars(ast_cast<FunctionDefExpr>(statement), boxes);
+                continue;
+            case ASTNodeType::VARIABLE_DECLARATION:
+                break;
+            default:
+                continue;
+        }
+        auto v = ast_cast<VariableDeclaration>(statement);
+        if (v->value->type != ASTNodeType::OBJECT_INSTANTIATION ||
+            v->annotation != Annotation::NONE || lets.at(v->name) != 1) {
+            continue;
+        }
+        auto it = boxes.find(
+            ast_cast<ObjectInstantiationExpr>(v->value.get())->class_name);
+        if (it == boxes.end() ||
+            !is_replaceable(v->name, it->second, statements, i + 1)) {
+            continue;
+        }
+        std::string name = v->name;
+        replace_attributes(statements, i + 1, name);
+        // a let per attribute in place of the instance
+        std::vector<uptr<Statement>> attributes;
+        for (const auto &attr : it->second->attributes) {
+            auto let = std::make_unique<VariableDeclaration>();
+            let->name = name + "." + attr->name;
+            Value value = ast_cast<LiteralExpr>(attr->value.get())->value;
+            // a number attribute can only ever be given another number
+            if (value.is_number()) let->annotation = Annotation::NUMBER;
+            let->attribute = true;
+            if (value.type() != ValueType::STRING) {
+                let->value = make_literal(value);
+                attributes.push_back(std::move(let));
+                continue;
+            }
+            // an instance has a copy of the string, not the literal
+            let->value = make_literal(Value::none());
+            auto store = std::make_unique<VariableDeclaration>();
+            store->type = ASTNodeType::VARIABLE_REASSIGN;
+            store->name = let->name;
+            store->value = make_literal(value);
+            store->attribute = true;
+            attributes.push_back(std::move(let));
+            attributes.push_back(std::move(store));
+        }
+        statements.erase(statements.begin() + i);
+        statements.insert(statements.begin() + i,
+                          std::make_move_iterator(attributes.begin()),
+                          std::make_move_iterator(attributes.end()));
+        i += attributes.size() - 1;
+    }
+}
+
+static void replace_scalars(FunctionDefExpr *function,
+                            const ScalarBoxes &boxes) {
+    // the variable of an instance has to be the only one of its name in the
+    // confection, so every use of the name after its let is that instance
+    std::unordered_map<std::string, int> lets;
+    visit(function, [&](ASTNode *n) {
+        if (n->type == ASTNodeType::VARIABLE_DECLARATION) {
+            lets[ast_cast<VariableDeclaration>(n)->name]++;
+        } else if (n->type == ASTNodeType::FUNCTION_DEFINITION) {
+            for (const auto &param : ast_cast<FunctionDefExpr>(n)->params) {
+                lets[param]++;
+            }
+        }
+    });
+    replace_scalars(function->statements, lets, boxes);
+}
+
+Optimizer::Optimizer(const GlobalTable &globals, const NativeRegistry &natives)
+    : globals(globals), natives(natives) {}
+
+void Optimizer::optimize(std::vector<uptr<Statement>> &ast) {
+    scan(ast);
+    optimize_block(ast);
+    replace_scalars(ast);
+}
+
+void Optimizer::optimize_block(std::vector<uptr<Statement>> &statements) {
+    std::vector<uptr<Statement>> result;
+    result.reserve(statements.size());
+    for (auto &s : statements) {
+        if (optimize_statement(s)) result.push_back(std::move(s));
+    }
+    statements = std::move(result);
+}
+
+bool Optimizer::optimize_statement(uptr<Statement> &statement) {
+    switch (statement->type) {
+        case ASTNodeType::VARIABLE_DECLARATION:
+        case ASTNodeType::VARIABLE_REASSIGN: {
+            auto v = ast_cast<VariableDeclaration>(statement.get());
+            optimize_expr(v->value);
+            bool propagate =
+                depth == 0 && v->type == ASTNodeType::VARIABLE_DECLARATION &&
+                is_immediate(v->value.get()) && declarations[v->name] == 1 &&
+                !reassigned.contains(v->name) && !globals.contains(v->name);
+            if (propagate) {
+                constants[v->name] =
+                    ast_cast<LiteralExpr>(v->value.get())->value;
+            }
+            return true;
+        }
+        case ASTNodeType::IF_STATEMENT: {
+            return optimize_if_statement(statement);
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            auto s = ast_cast<WhileExpr>(statement.get());
+            optimize_expr(s->condition);
+            depth++;
+            optimize_block(s->statements);
+            depth--;
+            if (is_bool_literal(s->condition.get(), false)) return false;
+            hoist_invariants(statement);
+            return true;
+        }
+        case ASTNodeType::BLOCK: {
+            depth++;
+            optimize_block(ast_cast<BlockExpr>(statement.get())->statements);
+            depth--;
+            return true;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION: {
+            depth++;
+            optimize_block(
+                ast_cast<FunctionDefExpr>(statement.get())->statements);
+            depth--;
+            return true;
+        }
+        case ASTNodeType::RETURN_STATEMENT: {
+            optimize_expr(ast_cast<ReturnExpr>(statement.get())->content);
+            return true;
+        }
+        case ASTNodeType::CLASS_DEFINITION: {
+            auto s = ast_cast<ClassDefinitionExpr>(statement.get());
+            for (auto &attr : s->attributes) {
+                optimize_expr(attr->value);
+            }
+            depth++;
+            for (auto &method : s->methods) {
+                optimize_block(method->statements);
+            }
+            depth--;
+            return true;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            auto s = ast_cast<ObjectAttrReassignExpr>(statement.get());
+            optimize_expr(s->right);
+            return true;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            auto s = ast_cast<IndexAssignExpr>(statement.get());
+            optimize_expr(s->head->container);
+            optimize_expr(s->head->index);
+            optimize_expr(s->right);
+            return true;
+        }
+        default: {
+            // expression statement, a literal on its own does nothing
+            uptr<Expr> expr{ast_cast<Expr>(statement.release())};
+            optimize_expr(expr);
+            statement = std::move(expr);
+            return statement->type != ASTNodeType::LITERAL;
+        }
+    }
+}
+
+bool Optimizer::optimize_if_statement(uptr<Statement> &statement) {
+    auto s = ast_cast<IfExpr>(statement.get());
+    optimize_expr(s->condition);
+    depth++;
+    optimize_block(s->statements);
+    for (auto &elif : s->elif_statements) {
+        optimize_expr(elif->condition);
+        optimize_block(elif->statements);
+    }
+    optimize_block(s->else_statements);
+    depth--;
+
+    // a false branch never runs, the next one takes its place
+    while (is_bool_literal(s->condition.get(), false)) {
+        if (s->elif_statements.empty()) {
+            if (s->else_statements.empty()) return false;
+            auto else_statements = std::move(s->else_statements);
+            statement = make_block(std::move(else_statements));
+            return true;
+        }
+        auto elif = std::move(s->elif_statements.front());
+        s->elif_statements.erase(s->elif_statements.begin());
+        s->condition = std::move(elif->condition);
+        s->statements = std::move(elif->statements);
+    }
+    // a true branch always runs and nothing after it does
+    if (is_bool_literal(s->condition.get(), true)) {
+        auto statements = std::move(s->statements);
+        statement = make_block(std::move(statements));
+        return true;
+    }
+    auto &elifs = s->elif_statements;
+    for (size_t i = 0; i < elifs.size(); ++i) {
+        if (is_bool_literal(elifs[i]->condition.get(), false)) {
+            elifs.erase(elifs.begin() + i--);
+        } else if (is_bool_literal(elifs[i]->condition.get(), true)) {
+            s->else_statements = std::move(elifs[i]->statements);
+            elifs.erase(elifs.begin() + i, elifs.end());
+        }
+    }
+    return true;
+}
+
+void Optimizer::hoist_invariants(uptr<Statement> &statement) {
+    auto s = ast_cast<WhileExpr>(statement.get());
+    // the condition is checked once more before the loop
+    if (has_call(s->condition.get())) return;
+    uptr<Expr> condition = clone(s->condition.get());
+    if (condition == nullptr) return;
+    LoopEffects effects;
+    bool definitions = false;
+    for (const auto &body : s->statements) {
+        visit(body.get(), [&](ASTNode *n) {
+            switch (n->type) {
+                case ASTNodeType::VARIABLE_DECLARATION:
+                case ASTNodeType::VARIABLE_REASSIGN:
+                    effects.variables.insert(
+                        ast_cast<VariableDeclaration>(n)->name);
+                    break;
+                case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+                    auto head = ast_cast<DotExpr>(
+                        ast_cast<ObjectAttrReassignExpr>(n)->head.get());
+                    effects.attributes.insert(
+                        ast_cast<SymbolExpr>(head->after.back().get())
+                            ->symbol);
+                    break;
+                }
+                case ASTNodeType::FUNCTION_CALL:
+                    // natives can't write variables or attributes
+                    if (natives.find(
+                            ast_cast<CallExpr>(n)->callee->symbol) < 0) {
+                        effects.calls = true;
+                    }
+                    break;
+                case ASTNodeType::OBJECT_INSTANTIATION:
+                    effects.calls = true;
+                    break;
+                case ASTNodeType::DOT_SYMBOL:
+                    // a method call, even one named like a native
+                    for (const auto &after : ast_cast<DotExpr>(n)->after) {
+                        effects.calls |=
+                            after->type == ASTNodeType::FUNCTION_CALL;
+                    }
+                    break;
+                case ASTNodeType::FUNCTION_DEFINITION:
+                case ASTNodeType::CLASS_DEFINITION:
+                    definitions = true;
+                    break;
+                default:
+                    break;
+            }
+        });
+    }
+    // a confection may reassign the globals the loop reads
+    if (effects.calls || definitions) return;
+
+    // only what runs on every iteration before anything observable may be
+    // computed ahead of it
+    std::vector<uptr<Expr> *> candidates;
+    for (auto &body : s->statements) {
+        if (has_call(body.get())) break;
+        bool gifts = false;
+        visit(body.get(), [&](ASTNode *n) {
+            gifts |= n->type == ASTNodeType::RETURN_STATEMENT;
+        });
+        if (gifts) break;
+        switch (body->type) {
+            case ASTNodeType::VARIABLE_DECLARATION:
+            case ASTNodeType::VARIABLE_REASSIGN:
+                candidates.push_back(
+                    &ast_cast<VariableDeclaration>(body.get())->value);
+                break;
+            case ASTNodeType::OBJECT_ATTR_REASSIGN:
+                candidates.push_back(
+                    &ast_cast<ObjectAttrReassignExpr>(body.get())->right);
+                break;
+            case ASTNodeType::INDEX_ASSIGN:
+                candidates.push_back(
+                    &ast_cast<IndexAssignExpr>(body.get())->right);
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::vector<uptr<Statement>> lets;
+    auto hoist = [&](auto &self, uptr<Expr> &expr) -> void {
+        bool trivial = expr->type == ASTNodeType::LITERAL ||
+                       expr->type == ASTNodeType::SYMBOL;
+        if (!trivial && is_invariant(expr.get(), effects)) {
+            auto let = std::make_unique<VariableDeclaration>();
+            let->name = fmt::format("$licm{}", hoisted++);
+            expr.swap(let->value);
+            expr = std::make_unique<SymbolExpr>(let->name);
+            lets.push_back(std::move(let));
+            return;
+        }
+        if (expr->type == ASTNodeType::BINARY) {
+            auto v = ast_cast<BinaryExpr>(expr.get());
+            self(self, v->left);
+            // the right of && and || doesn't always run
+            if (v->op != TokenType::AND && v->op != TokenType::OR) {
+                self(self, v->right);
+            }
+        } else if (expr->type == ASTNodeType::UNARY) {
+            self(self, ast_cast<UnaryExpr>(expr.get())->unary);
+        }
+    };
+    for (uptr<Expr> *expr : candidates) hoist(hoist, *expr);
+    if (lets.empty()) return;
+
+    auto rotated = std::make_unique<IfExpr>();
+    rotated->condition = std::move(condition);
+    rotated->statements = std::move(lets);
+    rotated->statements.push_back(std::move(statement));
+    statement = std::move(rotated);
+}
+
+void Optimizer::replace_scalars(std::vector<uptr<Statement>> &ast) {
+    // a box defined once at the top level exists by the time any confection
+    // defined after it runs, so `new` can't fail there
+    std::unordered_map<std::string, int> definitions;
+    for (const auto &statement : ast) {
+        visit(statement.get(), [&](ASTNode *n) {
+            if (n->type == ASTNodeType::CLASS_DEFINITION) {
+                definitions[ast_cast<ClassDefinitionExpr>(n)->name]++;
+            }
+        });
+    }
+    ScalarBoxes boxes;
+    for (const auto &statement : ast) {
+        if (statement->type == ASTNodeType::CLASS_DEFINITION) {
+            auto s = ast_cast<ClassDefinitionExpr>(statement.get());
+            if (definitions[s->name] == 1 && is_scalar_box(s)) {
+                boxes[s->name] = s;
+            }
+            for (auto &method : s->methods) {
+                ::replace_scalars(method.get(), boxes);
+            }
+        } else if (statement->type == ASTNodeType::FUNCTION_DEFINITION) {
+            ::replace_scalars(ast_cast<FunctionDefExpr>(statement.get()),
+                              boxes);
+        }
+    }
+}
+
+void Optimizer::optimize_expr(uptr<Expr> &expr) {
+    switch (expr->type) {
+        case ASTNodeType::LIST: {
+            for (auto &element : ast_cast<ListExpr>(expr.get())->elements) {
+                optimize_expr(element);
+            }
+            return;
+        }
+        case ASTNodeType::SYMBOL: {
+            auto it = constants.find(ast_cast<SymbolExpr>(expr.get())->symbol);
+            if (it != constants.end()) expr = make_literal(it->second);
+            return;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr.get());
+            optimize_expr(v->left);
+            optimize_expr(v->right);
+            if (!is_immediate(v->left.get()) ||
+                !is_immediate(v->right.get())) {
+                return;
+            }
+            Value left = ast_cast<LiteralExpr>(v->left.get())->value;
+            Value right = ast_cast<LiteralExpr>(v->right.get())->value;
+            // anything that is an error is left for the VM to report
+            Value result;
+            bool folded = false;
+            if (left.is_number() && right.is_number()) {
+                folded = numeric_op(v->op, left, right, result);
+            } else if (left.is_bool() && right.is_bool()) {
+                folded =
+                    bool_op(v->op, left.as_bool(), right.as_bool(), result);
+            }
+            if (folded) expr = make_literal(result);
+            return;
+        }
+        case ASTNodeType::UNARY: {
+            auto v = ast_cast<UnaryExpr>(expr.get());
+            optimize_expr(v->unary);
+            if (v->unary->type != ASTNodeType::LITERAL) return;
+            Value value = ast_cast<LiteralExpr>(v->unary.get())->value;
+            if (v->op == TokenType::MINUS && value.is_number()) {
+                expr = make_literal(
+                    value.is_int() ? Value::integer(-(int64_t)value.as_int())
+                                   : Value::number(-value.as_number()));
+            } else if (v->op == TokenType::NOT && value.is_bool()) {
+                expr = make_literal(Value::boolean(!value.as_bool()));
+            }
+            return;
+        }
+        case ASTNodeType::FUNCTION_CALL: {
+            for (auto &param : ast_cast<CallExpr>(expr.get())->params) {
+                optimize_expr(param);
+            }
+            return;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(expr.get());
+            optimize_expr(v->container);
+            optimize_expr(v->index);
+            return;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            // the head of a dot expression stays a symbol, a literal there
+            // is an error either way
+            for (auto &after : ast_cast<DotExpr>(expr.get())->after) {
+                if (after->type != ASTNodeType::FUNCTION_CALL) continue;
+                for (auto &param : ast_cast<CallExpr>(after.get())->params) {
+                    optimize_expr(param);
+                }
+            }
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+void Optimizer::scan(const std::vector<uptr<Statement>> &statements) {
+    for (const auto &statement : statements) {
+        switch (statement->type) {
+            case ASTNodeType::VARIABLE_DECLARATION: {
+                auto v = ast_cast<VariableDeclaration>(statement.get());
+                declarations[v->name]++;
+                break;
+            }
+            case ASTNodeType::VARIABLE_REASSIGN: {
+                reassigned.insert(
+                    ast_cast<VariableDeclaration>(statement.get())->name);
+                break;
+            }
+            case ASTNodeType::IF_STATEMENT: {
+                auto s = ast_cast<IfExpr>(statement.get());
+                scan(s->statements);
+                for (const auto &elif : s->elif_statements) {
+                    scan(elif->statements);
+                }
+                scan(s->else_statements);
+                break;
+            }
+            case ASTNodeType::WHILE_STATEMENT: {
+                scan(ast_cast<WhileExpr>(statement.get())->statements);
+                break;
+            }
+            case ASTNodeType::BLOCK: {
+                scan(ast_cast<BlockExpr>(statement.get())->statements);
+                break;
+            }
+            case ASTNodeType::FUNCTION_DEFINITION: {
+                auto s = ast_cast<FunctionDefExpr>(statement.get());
+                for (const auto &param : s->params) {
+                    declarations[param]++;
+                }
+                scan(s->statements);
+                break;
+            }
+            case ASTNodeType::CLASS_DEFINITION: {
+                auto s = ast_cast<ClassDefinitionExpr>(statement.get());
+                for (const auto &method : s->methods) {
+                    for (const auto &param : method->params) {
+                        declarations[param]++;
+                    }
+                    scan(method->statements);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
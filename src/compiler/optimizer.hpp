@@ -0,0 +1,63 @@
+#ifndef COMPILER_OPTIMIZER_HPP
+#define COMPILER_OPTIMIZER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "compiler/resolver.hpp"
+#include "runtime/natives.hpp"
+#include "runtime/value.hpp"
+
+// rewrites the AST from Parser::parse() before it is resolved: folds
+// constant number/bool operators into literals, drops if/elif/while
+// branches whose condition is a constant and replaces the uses of
+// top-level lets that are never reassigned with their value. Loop-invariant
+// arithmetic and attribute loads at the top of a while body are computed
+// once before the loop instead, and a box made by a confection that never
+// lets it escape becomes a local per attribute
+class Optimizer {
+  public:
+    Optimizer(const GlobalTable &globals, const NativeRegistry &natives);
+    void optimize(std::vector<uptr<Statement>> &ast);
+
+    // the lets whose uses were replaced, see GlobalTable::constants
+    const std::unordered_map<std::string, Value> &propagated() const {
+        return constants;
+    }
+
+  private:
+    void optimize_block(std::vector<uptr<Statement>> &statements);
+    // returns false if the statement can be removed
+    bool optimize_statement(uptr<Statement> &statement);
+    bool optimize_if_statement(uptr<Statement> &statement);
+    void optimize_expr(uptr<Expr> &expr);
+    // rewrites `while (c) { ... }` into `if (c) { let $licm0 = ...;
+    // while (c) { ... } }` when it finds something to hoist
+    void hoist_invariants(uptr<Statement> &statement);
+    // rewrites `let v = new Vec2(); v.x = 1;` into `let v.x = 0;
+    // let v.y = 0; v.x = 1;` in confections where v is only ever used
+    // through its attributes, no instance is made
+    void replace_scalars(std::vector<uptr<Statement>> &ast);
+
+    // counts the declarations and finds the reassignments of every name
+    void scan(const std::vector<uptr<Statement>> &statements);
+
+    // a propagated let has to be the only declaration of its name in the
+    // program, so no local can shadow it
+    std::unordered_map<std::string, int> declarations;
+    std::unordered_set<std::string> reassigned;
+    // number/bool values of the top-level lets seen so far, only code after
+    // the let can use them
+    std::unordered_map<std::string, Value> constants;
+    int depth = 0;
+    // names the hoisted temporaries
+    uint32_t hoisted = 0;
+
+    const GlobalTable &globals;
+    const NativeRegistry &natives;
+};
+
+#endif // COMPILER_OPTIMIZER_HPP
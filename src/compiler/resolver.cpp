@@ -0,0 +1,415 @@
+#include "resolver.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+
+#include "ast.hpp"
+#include "util/error.hpp"
+
+uint32_t GlobalTable::slot(const std::string &name) {
+    auto it = slots.find(name);
+    if (it != slots.end()) return it->second;
+    names.push_back(name);
+    slots[name] = names.size() - 1;
+    return names.size() - 1;
+}
+
+bool GlobalTable::contains(const std::string &name) const {
+    return slots.contains(name);
+}
+
+uint32_t FunctionTable::declare(const std::string &name, size_t arity) {
+    names.push_back(name);
+    arities.push_back(arity);
+    slots[name] = names.size() - 1;
+    return names.size() - 1;
+}
+
+int64_t FunctionTable::find(const std::string &name) const {
+    auto it = slots.find(name);
+    if (it == slots.end()) return -1;
+    return it->second;
+}
+
+Resolver::Resolver(const GlobalTable &globals,
+                   FunctionTable &functions,
+                   const NativeRegistry &natives)
+    : globals(globals), functions(functions), natives(natives) {}
+
+uint32_t Resolver::resolve(const std::vector<uptr<Statement>> &ast) {
+    // calls may come before the definition they call
+    declare_functions(ast);
+    for (const auto &s : ast) {
+        if (s->type == ASTNodeType::VARIABLE_DECLARATION) {
+            auto v = ast_cast<VariableDeclaration>(s.get());
+            program_globals[v->name] = v->annotation;
+        }
+    }
+    for (const auto &s : ast) {
+        resolve_statement(s.get());
+    }
+    for (FunctionDefExpr *function : program_functions) {
+        functions.declare(function->name, function->params.size());
+    }
+    return frame_slots;
+}
+
+const std::unordered_map<std::string, Annotation> &
+Resolver::global_types() const {
+    return program_globals;
+}
+
+void Resolver::resolve_statement(Statement *statement) {
+    switch (statement->type) {
+        case ASTNodeType::VARIABLE_DECLARATION: {
+            auto v = ast_cast<VariableDeclaration>(statement);
+            // the value may still refer to an outer variable of the same name
+            resolve_expr(v->value.get());
+            declare(v->name, v->binding, v->annotation);
+            return;
+        }
+        case ASTNodeType::VARIABLE_REASSIGN: {
+            auto v = ast_cast<VariableDeclaration>(statement);
+            resolve_expr(v->value.get());
+            if (!bind(v->name, v->binding)) {
+                throw Error(
+                    Error::NAME_ERROR,
+                    fmt::format("Error: Variable name '{}' does not exist!\n",
+                                v->name));
+            }
+            if (v->binding.global && globals.constants.contains(v->name)) {
+                throw Error(Error::NAME_ERROR,
+                            fmt::format("Error: Variable name '{}' was "
+                                        "propagated as a constant and can't "
+                                        "be reassigned.",
+                                        v->name));
+            }
+            return;
+        }
+        case ASTNodeType::IF_STATEMENT: {
+            auto s = ast_cast<IfExpr>(statement);
+            resolve_expr(s->condition.get());
+            resolve_block(s->statements);
+            for (const auto &elif : s->elif_statements) {
+                resolve_expr(elif->condition.get());
+                resolve_block(elif->statements);
+            }
+            resolve_block(s->else_statements);
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            auto s = ast_cast<WhileExpr>(statement);
+            resolve_expr(s->condition.get());
+            resolve_block(s->statements);
+            return;
+        }
+        case ASTNodeType::BLOCK: {
+            resolve_block(ast_cast<BlockExpr>(statement)->statements);
+            return;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION: {
+            resolve_function(ast_cast<FunctionDefExpr>(statement));
+            return;
+        }
+        case ASTNodeType::RETURN_STATEMENT: {
+            resolve_expr(ast_cast<ReturnExpr>(statement)->content.get());
+            return;
+        }
+        case ASTNodeType::CLASS_DEFINITION: {
+            // default values are evaluated like the body of a function
+            auto s = ast_cast<ClassDefinitionExpr>(statement);
+            auto saved_scopes = std::move(scopes);
+            bool saved_in_function = in_function;
+            scopes.assign(1, {});
+            in_function = true;
+            for (const auto &attr : s->attributes) {
+                resolve_expr(attr->value.get());
+            }
+            scopes = std::move(saved_scopes);
+            in_function = saved_in_function;
+            for (const auto &method : s->methods) {
+                resolve_function(method.get());
+            }
+            return;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            auto s = ast_cast<ObjectAttrReassignExpr>(statement);
+            resolve_expr(s->head.get());
+            resolve_expr(s->right.get());
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            auto s = ast_cast<IndexAssignExpr>(statement);
+            resolve_expr(s->head.get());
+            resolve_expr(s->right.get());
+            return;
+        }
+        default: {
+            resolve_expr(ast_cast<Expr>(statement));
+            return;
+        }
+    }
+}
+
+void Resolver::resolve_block(const std::vector<uptr<Statement>> &statements) {
+    uint32_t saved_next_slot = next_slot;
+    scopes.emplace_back();
+    for (const auto &s : statements) {
+        resolve_statement(s.get());
+    }
+    scopes.pop_back();
+    next_slot = saved_next_slot;
+}
+
+void Resolver::resolve_function(FunctionDefExpr *function) {
+    // functions only see their own locals and the globals
+    auto saved_scopes = std::move(scopes);
+    bool saved_in_function = in_function;
+    uint32_t saved_next_slot = next_slot;
+    uint32_t saved_frame_slots = frame_slots;
+    scopes.assign(1, {});
+    in_function = true;
+    next_slot = 0;
+    frame_slots = 0;
+
+    // the arguments are the first slots of the frame
+    for (size_t i = 0; i < function->params.size(); ++i) {
+        Binding binding;
+        declare(function->params[i], binding, function->param_types[i]);
+    }
+    for (const auto &s : function->statements) {
+        resolve_statement(s.get());
+    }
+    function->frame_slots = frame_slots;
+
+    scopes = std::move(saved_scopes);
+    in_function = saved_in_function;
+    next_slot = saved_next_slot;
+    frame_slots = saved_frame_slots;
+}
+
+void Resolver::resolve_expr(Expr *expr) {
+    switch (expr->type) {
+        case ASTNodeType::LIST: {
+            for (auto &element : ast_cast<ListExpr>(expr)->elements) {
+                resolve_expr(element.get());
+            }
+            return;
+        }
+        case ASTNodeType::SYMBOL: {
+            auto symbol = ast_cast<SymbolExpr>(expr);
+            if (!bind(symbol->symbol, symbol->binding)) {
+                throw Error(Error::NAME_ERROR,
+                            fmt::format("Variable '{}' is not in scope and "
+                                        "does not exist!",
+                                        symbol->symbol));
+            }
+            return;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            // everything after the head is an attribute or method name, the
+            // method is found from the instance when the call runs
+            auto v = ast_cast<DotExpr>(expr);
+            resolve_expr(v->head.get());
+            for (const auto &after : v->after) {
+                if (after->type != ASTNodeType::FUNCTION_CALL) continue;
+                for (auto &param : ast_cast<CallExpr>(after.get())->params) {
+                    resolve_expr(param.get());
+                }
+            }
+            return;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(expr);
+            resolve_expr(v->container.get());
+            resolve_expr(v->index.get());
+            return;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            resolve_expr(v->left.get());
+            resolve_expr(v->right.get());
+            return;
+        }
+        case ASTNodeType::UNARY: {
+            resolve_expr(ast_cast<UnaryExpr>(expr)->unary.get());
+            return;
+        }
+        case ASTNodeType::FUNCTION_CALL: {
+            resolve_call(ast_cast<CallExpr>(expr));
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+void Resolver::resolve_call(CallExpr *call) {
+    // the callee is a function name, not a variable
+    for (auto &param : call->params) {
+        resolve_expr(param.get());
+    }
+    const std::string &name = call->callee->symbol;
+    size_t argc = call->params.size();
+
+    int64_t native = natives.find(name);
+    if (native >= 0) {
+        int arity = natives[native].arity;
+        if (arity >= 0 && (size_t)arity != argc) {
+            throw Error(
+                Error::ARGUMENT_ERROR,
+                fmt::format("Expected {} arguments but got {}.", arity, argc));
+        }
+        call->target = {Callee::NATIVE, (uint32_t)native};
+        return;
+    }
+
+    size_t arity;
+    auto it = program_function_names.find(name);
+    if (it != program_function_names.end()) {
+        call->target = {Callee::FUNCTION, it->second->slot};
+        arity = it->second->params.size();
+    } else {
+        int64_t slot = functions.find(name);
+        if (slot < 0) {
+            throw Error(
+                Error::NAME_ERROR,
+                fmt::format("Error: Function '{}' does not exist.", name));
+        }
+        call->target = {Callee::FUNCTION, (uint32_t)slot};
+        arity = functions.arities[slot];
+    }
+    if (arity != argc) {
+        throw Error(Error::INVALID_ARGUMENT_ERROR,
+                    fmt::format("Error: Function definition '{}' has {} "
+                                "parameters but got {} arguments.",
+                                name,
+                                arity,
+                                argc));
+    }
+}
+
+void Resolver::declare_functions(
+    const std::vector<uptr<Statement>> &statements) {
+    for (const auto &statement : statements) {
+        switch (statement->type) {
+            case ASTNodeType::FUNCTION_DEFINITION: {
+                auto s = ast_cast<FunctionDefExpr>(statement.get());
+                if (natives.find(s->name) >= 0 ||
+                    functions.find(s->name) >= 0 ||
+                    program_function_names.contains(s->name)) {
+                    throw Error(
+                        Error::NAME_ERROR,
+                        fmt::format("Error: Function name '{}' already "
+                                    "declared.",
+                                    s->name));
+                }
+                // the slot it will get once the program is resolved
+                s->slot = functions.names.size() + program_functions.size();
+                program_functions.push_back(s);
+                program_function_names[s->name] = s;
+                declare_functions(s->statements);
+                break;
+            }
+            case ASTNodeType::IF_STATEMENT: {
+                auto s = ast_cast<IfExpr>(statement.get());
+                declare_functions(s->statements);
+                for (const auto &elif : s->elif_statements) {
+                    declare_functions(elif->statements);
+                }
+                declare_functions(s->else_statements);
+                break;
+            }
+            case ASTNodeType::WHILE_STATEMENT: {
+                declare_functions(
+                    ast_cast<WhileExpr>(statement.get())->statements);
+                break;
+            }
+            case ASTNodeType::BLOCK: {
+                declare_functions(
+                    ast_cast<BlockExpr>(statement.get())->statements);
+                break;
+            }
+            case ASTNodeType::CLASS_DEFINITION: {
+                auto s = ast_cast<ClassDefinitionExpr>(statement.get());
+                for (size_t i = 0; i < s->methods.size(); ++i) {
+                    FunctionDefExpr *method = s->methods[i].get();
+                    // `Box.name` can't clash with a confection, only with
+                    // the other members of the box
+                    std::string name =
+                        method->name.substr(s->name.size() + 1);
+                    bool taken = std::any_of(
+                        s->attributes.begin(),
+                        s->attributes.end(),
+                        [&](const auto &attr) { return attr->name == name; });
+                    for (size_t j = 0; j < i; ++j) {
+                        taken |= s->methods[j]->name == method->name;
+                    }
+                    if (taken) {
+                        throw Error(
+                            Error::NAME_ERROR,
+                            fmt::format("Error: Function name '{}' already "
+                                        "declared.",
+                                        method->name));
+                    }
+                    method->slot =
+                        functions.names.size() + program_functions.size();
+                    program_functions.push_back(method);
+                    declare_functions(method->statements);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void Resolver::declare(const std::string &name, Binding &binding,
+                       Annotation type) {
+    binding.type = type;
+    if (scopes.empty()) {
+        if (!declared_globals.insert(name).second) {
+            throw Error(
+                Error::NAME_ERROR,
+                fmt::format("Error: Variable name '{}' already declared.",
+                            name));
+        }
+        binding.global = true;
+        return;
+    }
+    auto &scope = scopes.back();
+    if (scope.contains(name)) {
+        throw Error(
+            Error::NAME_ERROR,
+            fmt::format("Error: Variable name '{}' already declared.", name));
+    }
+    binding.global = false;
+    binding.slot = next_slot++;
+    frame_slots = std::max(frame_slots, next_slot);
+    scope[name] = binding;
+}
+
+bool Resolver::bind(const std::string &name, Binding &binding) {
+    for (size_t i = scopes.size(); i-- > 0;) {
+        auto it = scopes[i].find(name);
+        if (it != scopes[i].end()) {
+            binding = it->second;
+            return true;
+        }
+    }
+    bool visible = in_function ? program_globals.contains(name)
+                               : declared_globals.contains(name);
+    if (!visible && !globals.contains(name)) return false;
+    binding.global = true;
+    auto it = program_globals.find(name);
+    if (it != program_globals.end()) {
+        binding.type = it->second;
+    } else {
+        auto typed = globals.types.find(name);
+        binding.type =
+            typed != globals.types.end() ? typed->second : Annotation::NONE;
+    }
+    return true;
+}
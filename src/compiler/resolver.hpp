@@ -0,0 +1,93 @@
+#ifndef COMPILER_RESOLVER_HPP
+#define COMPILER_RESOLVER_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "runtime/natives.hpp"
+#include "util/error.hpp"
+
+// global variable names and their slots, kept across eval() calls so later
+// programs see the globals of earlier ones
+struct GlobalTable {
+    uint32_t slot(const std::string &name);
+    bool contains(const std::string &name) const;
+
+    std::vector<std::string> names;
+    // globals the Optimizer replaced with their value in the code of their
+    // own program, later programs can't reassign them
+    std::unordered_set<std::string> constants;
+    // annotations of the typed globals
+    std::unordered_map<std::string, Annotation> types;
+
+  private:
+    std::unordered_map<std::string, uint32_t> slots;
+};
+
+// user function names, their slots and parameter counts, kept across eval()
+// calls like GlobalTable
+struct FunctionTable {
+    uint32_t declare(const std::string &name, size_t arity);
+    // returns -1 if no function called name was declared
+    int64_t find(const std::string &name) const;
+
+    std::vector<std::string> names;
+    std::vector<size_t> arities;
+
+  private:
+    std::unordered_map<std::string, uint32_t> slots;
+};
+
+// binds every SymbolExpr and VariableDeclaration to a scope slot so the
+// interpreter never looks variables up by name, and every CallExpr to the
+// native or function it calls. Undefined and redeclared names and wrong
+// argument counts are reported here before anything runs
+class Resolver {
+  public:
+    Resolver(const GlobalTable &globals,
+             FunctionTable &functions,
+             const NativeRegistry &natives);
+    // returns the frame size the blocks of the top-level code need
+    uint32_t resolve(const std::vector<uptr<Statement>> &ast);
+    // the annotation of every global the program declared, NONE if it has
+    // none
+    const std::unordered_map<std::string, Annotation> &global_types() const;
+
+  private:
+    void resolve_statement(Statement *statement);
+    void resolve_block(const std::vector<uptr<Statement>> &statements);
+    void resolve_function(FunctionDefExpr *function);
+    void resolve_expr(Expr *expr);
+    void resolve_call(CallExpr *call);
+    // finds the function definitions of the program, wherever they are
+    void declare_functions(const std::vector<uptr<Statement>> &statements);
+
+    void declare(const std::string &name, Binding &binding,
+                 Annotation type);
+    bool bind(const std::string &name, Binding &binding);
+
+    // local scopes, innermost last, empty at the top level. A block's locals
+    // take the frame slots after the enclosing ones and give them back when
+    // it ends, so sibling blocks share slots
+    std::vector<std::unordered_map<std::string, Binding>> scopes;
+    uint32_t next_slot = 0;
+    uint32_t frame_slots = 0;
+    // top-level code runs in order, so it may only use globals declared
+    // above it; function bodies may use any global of the program
+    std::unordered_set<std::string> declared_globals;
+    std::unordered_map<std::string, Annotation> program_globals;
+    bool in_function = false;
+    // functions of this program, added to the FunctionTable once resolved
+    std::vector<FunctionDefExpr *> program_functions;
+    std::unordered_map<std::string, FunctionDefExpr *> program_function_names;
+
+    const GlobalTable &globals;
+    FunctionTable &functions;
+    const NativeRegistry &natives;
+};
+
+#endif // COMPILER_RESOLVER_HPP
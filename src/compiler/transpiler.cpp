@@ -0,0 +1,729 @@
+#include "transpiler.hpp"
+
+#include <fmt/core.h>
+
+#include <cmath>
+
+#include "ast.hpp"
+#include "compiler/compiler.hpp"
+#include "compiler/optimizer.hpp"
+#include "runtime/graphics.hpp"
+#include "token.hpp"
+#include "util/error.hpp"
+
+// the enumerator of a binary operator in the generated code
+static const char *operator_name(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS:
+            return "TokenType::PLUS";
+        case TokenType::MINUS:
+            return "TokenType::MINUS";
+        case TokenType::MUL:
+            return "TokenType::MUL";
+        case TokenType::DIV:
+            return "TokenType::DIV";
+        case TokenType::LT:
+            return "TokenType::LT";
+        case TokenType::GT:
+            return "TokenType::GT";
+        case TokenType::LOT:
+            return "TokenType::LOT";
+        case TokenType::GOT:
+            return "TokenType::GOT";
+        case TokenType::EQUALS:
+            return "TokenType::EQUALS";
+        case TokenType::NOT_EQUAL:
+            return "TokenType::NOT_EQUAL";
+        default:
+            throw Error(Error::SYNTAX_ERROR,
+                        fmt::format("Error: Invalid operation '{}'.", op));
+    }
+}
+
+static const char *annotation_enum(Annotation type) {
+    switch (type) {
+        case Annotation::NUMBER:
+            return "Annotation::NUMBER";
+        case Annotation::WHOLE:
+            return "Annotation::WHOLE";
+        case Annotation::UNSIGNED:
+            return "Annotation::UNSIGNED";
+        case Annotation::CHAR:
+            return "Annotation::CHAR";
+        default:
+            return "Annotation::NONE";
+    }
+}
+
+// a C++ string literal holding text, octal escapes never run into the
+// characters after them
+static std::string quote(const std::string &text) {
+    std::string result = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (c < ' ' || c >= 0x7f) {
+            result += fmt::format("\\{:03o}", c);
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static std::string join(const std::vector<std::string> &items) {
+    std::string result;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i > 0) result += ", ";
+        result += items[i];
+    }
+    return result;
+}
+
+// !condition without stacking up negations
+static std::string negated(const std::string &condition) {
+    if (condition[0] == '!') return condition.substr(1);
+    return "!" + condition;
+}
+
+Transpiler::Transpiler() {
+    define_core_natives(natives);
+    define_graphics_natives(natives);
+}
+
+std::string Transpiler::transpile(std::vector<uptr<Statement>> &ast) {
+    Optimizer optimizer{globals, natives};
+    optimizer.optimize(ast);
+    Resolver resolver{globals, functions, natives};
+    uint32_t main_slots = resolver.resolve(ast);
+
+    indent = 1;
+    for (const auto &s : ast) {
+        emit_statement(s.get());
+    }
+    std::string main = "void run_main() {\n";
+    if (main_slots > 0) main += fmt::format("    Value s[{}];\n", main_slots);
+    main += body + "}\n";
+
+    // writing a confection may find more definitions
+    std::string definitions_code;
+    for (size_t i = 0; i < definitions.size(); ++i) {
+        definitions_code += "\n" + emit_function(definitions[i]);
+    }
+    for (size_t i = 0; i < classes.size(); ++i) {
+        definitions_code += "\n" + emit_class(classes[i], i);
+    }
+
+    std::string code = "// generated by `choco --emit-cpp`, build it against "
+                       "the choco_runtime library\n"
+                       "#include \"runtime/aot.hpp\"\n\n"
+                       "namespace {\n\n";
+    std::vector<std::string> names;
+    for (const auto &name : globals.names) names.push_back(quote(name));
+    code += fmt::format("AotRuntime rt{{\n    // globals\n    {{{}}},\n",
+                        join(names));
+    names.clear();
+    for (const auto &name : functions.names) names.push_back(quote(name));
+    code += fmt::format("    // confections\n    {{{}}},\n", join(names));
+    names.clear();
+    for (const auto &name : native_names) names.push_back(quote(name));
+    code += fmt::format("    // natives\n    {{{}}}}};\n", join(names));
+    if (!constants.empty()) code += "\n" + constants;
+
+    if (!definitions.empty() || !classes.empty()) code += "\n";
+    for (FunctionDefExpr *s : definitions) {
+        std::vector<std::string> params;
+        for (size_t i = 0; i < s->params.size(); ++i) {
+            params.push_back(fmt::format("Value p{}", i));
+        }
+        code += fmt::format("Value f{}({});\n", s->slot, join(params));
+    }
+    for (size_t i = 0; i < classes.size(); ++i) {
+        code += fmt::format("Value new{}();\n", i);
+    }
+    for (size_t i = 0; i < classes.size(); ++i) {
+        ClassDefinitionExpr *s = classes[i];
+        std::vector<std::string> attributes;
+        for (const auto &attr : s->attributes) {
+            attributes.push_back(quote(attr->name));
+        }
+        // every method gets a thunk taking its arguments as one array
+        std::vector<std::string> methods;
+        for (const auto &method : s->methods) {
+            std::vector<std::string> args;
+            for (size_t j = 0; j < method->params.size(); ++j) {
+                args.push_back(fmt::format("a[{}]", j));
+            }
+            code += fmt::format(
+                "Value m{}(const Value *a) {{\n    return f{}({});\n}}\n",
+                method->slot,
+                method->slot,
+                join(args));
+            methods.push_back(
+                fmt::format("{{{}, {}, {}, m{}}}",
+                            quote(method->name.substr(s->name.size() + 1)),
+                            method->slot,
+                            method->params.size(),
+                            method->slot));
+        }
+        if (methods.empty()) {
+            code += fmt::format("AotClass box{}{{{}, {{{}}}, new{}}};\n",
+                                i,
+                                quote(s->name),
+                                join(attributes),
+                                i);
+            continue;
+        }
+        code += fmt::format("AotClass box{}{{{}, {{{}}}, new{}, {{{}}}}};\n",
+                            i,
+                            quote(s->name),
+                            join(attributes),
+                            i,
+                            join(methods));
+    }
+
+    code += definitions_code + "\n" + main + "\n} // namespace\n\n";
+    code += "int main() {\n    return rt.run(run_main);\n}\n";
+    return code;
+}
+
+std::string Transpiler::emit_function(FunctionDefExpr *s) {
+    body.clear();
+    indent = 1;
+    temps = 0;
+    function = s;
+    tail_loop = false;
+    for (const auto &statement : s->statements) {
+        emit_statement(statement.get());
+    }
+    function = nullptr;
+
+    std::vector<std::string> params;
+    std::vector<std::string> args;
+    for (size_t i = 0; i < s->params.size(); ++i) {
+        params.push_back(fmt::format("Value p{}", i));
+        args.push_back(fmt::format("p{}", i));
+    }
+    std::string code =
+        fmt::format("// confection {}({})\n", s->name, join(s->params));
+    code += fmt::format("Value f{}({}) {{\n", s->slot, join(params));
+    // the order CALL checks things in
+    code += fmt::format("    rt.check_function({});\n", s->slot);
+    for (size_t i = 0; i < s->params.size(); ++i) {
+        if (s->param_types[i] == Annotation::NONE) continue;
+        code += fmt::format("    rt.check_type(p{}, {}, {});\n",
+                            i,
+                            annotation_enum(s->param_types[i]),
+                            quote(s->params[i]));
+    }
+    code += fmt::format("    AotFrame frame{{rt, {}}};\n", quote(s->name));
+    if (s->frame_slots > 0) {
+        code += fmt::format("    Value s[{}] = {{{}}};\n",
+                            s->frame_slots,
+                            join(args));
+    }
+    if (tail_loop) code += "start:\n";
+    code += body;
+    code += "    return Value::none();\n}\n";
+    return code;
+}
+
+std::string Transpiler::emit_class(ClassDefinitionExpr *s, size_t index) {
+    body.clear();
+    indent = 1;
+    temps = 0;
+    std::vector<std::string> values;
+    bool literals = true;
+    for (const auto &attr : s->attributes) {
+        values.push_back(emit_expr(attr->value.get()));
+        literals &= attr->value->type == ASTNodeType::LITERAL;
+    }
+    std::string code = fmt::format("// box {}\n", s->name);
+    code += fmt::format("Value new{}() {{\n", index);
+    // default values are evaluated like the body of a function, the VM
+    // only needs a frame for them when one isn't a literal
+    if (!literals) {
+        code += fmt::format("    AotFrame frame{{rt, {}}};\n",
+                            quote(s->name));
+    }
+    code += body;
+    code += fmt::format("    return rt.build_object(box{}, {{{}}});\n}}\n",
+                        index,
+                        join(values));
+    return code;
+}
+
+void Transpiler::emit_statement(Statement *statement) {
+    switch (statement->type) {
+        case ASTNodeType::VARIABLE_REASSIGN:
+        case ASTNodeType::VARIABLE_DECLARATION: {
+            emit_variable_declaration(ast_cast<VariableDeclaration>(statement));
+            return;
+        }
+        case ASTNodeType::IF_STATEMENT: {
+            emit_if_statement(ast_cast<IfExpr>(statement));
+            return;
+        }
+        case ASTNodeType::WHILE_STATEMENT: {
+            emit_while_statement(ast_cast<WhileExpr>(statement));
+            return;
+        }
+        case ASTNodeType::BLOCK: {
+            emit_block(ast_cast<BlockExpr>(statement)->statements);
+            return;
+        }
+        case ASTNodeType::FUNCTION_DEFINITION: {
+            auto s = ast_cast<FunctionDefExpr>(statement);
+            definitions.push_back(s);
+            line(fmt::format("rt.define_function({});", s->slot));
+            return;
+        }
+        case ASTNodeType::RETURN_STATEMENT: {
+            emit_return(ast_cast<ReturnExpr>(statement));
+            return;
+        }
+        case ASTNodeType::CLASS_DEFINITION: {
+            auto s = ast_cast<ClassDefinitionExpr>(statement);
+            // the same check Compiler::compile_class_definition makes
+            for (size_t i = 0; i < s->attributes.size(); ++i) {
+                for (size_t j = 0; j < i; ++j) {
+                    if (s->attributes[j]->name == s->attributes[i]->name) {
+                        throw Error(Error::NAME_ERROR,
+                                    fmt::format("Error: Variable name '{}' "
+                                                "already declared.",
+                                                s->attributes[i]->name));
+                    }
+                }
+            }
+            // the methods are written out and defined like confections
+            for (const auto &method : s->methods) {
+                definitions.push_back(method.get());
+                line(fmt::format("rt.define_function({});", method->slot));
+            }
+            line(fmt::format("rt.define_class(box{});", classes.size()));
+            classes.push_back(s);
+            return;
+        }
+        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
+            emit_object_attr_reassign(
+                ast_cast<ObjectAttrReassignExpr>(statement));
+            return;
+        }
+        case ASTNodeType::INDEX_ASSIGN: {
+            emit_index_assign(ast_cast<IndexAssignExpr>(statement));
+            return;
+        }
+        default: {
+            // expression statement, the value is discarded
+            Expr *expr = ast_cast<Expr>(statement);
+            if (expr->type == ASTNodeType::FUNCTION_CALL) {
+                line(emit_call(ast_cast<CallExpr>(expr)) + ";");
+                return;
+            }
+            line(fmt::format("(void){};", emit_expr(expr)));
+            return;
+        }
+    }
+}
+
+void Transpiler::emit_block(const std::vector<uptr<Statement>> &statements) {
+    for (const auto &s : statements) {
+        emit_statement(s.get());
+    }
+}
+
+void Transpiler::emit_variable_declaration(VariableDeclaration *v) {
+    std::string value = emit_expr(v->value.get());
+    const Binding &binding = v->binding;
+    if (v->attribute) {
+        // a box the Optimizer keeps in locals, its first value is a literal
+        // of the attribute's type
+        if (v->type == ASTNodeType::VARIABLE_REASSIGN) {
+            line(fmt::format(
+                "rt.assign_attr(s[{}], {});", binding.slot, value));
+        } else {
+            line(fmt::format("s[{}] = {};", binding.slot, value));
+        }
+        return;
+    }
+    if (binding.type != Annotation::NONE) {
+        line(fmt::format("rt.check_type({}, {}, {});",
+                         value,
+                         annotation_enum(binding.type),
+                         quote(v->name)));
+    }
+    if (!binding.global) {
+        line(fmt::format("s[{}] = {};", binding.slot, value));
+    } else if (v->type == ASTNodeType::VARIABLE_DECLARATION) {
+        line(fmt::format(
+            "rt.define_global({}, {});", globals.slot(v->name), value));
+    } else {
+        line(fmt::format(
+            "rt.set_global({}, {});", globals.slot(v->name), value));
+    }
+}
+
+void Transpiler::emit_if_statement(IfExpr *s) {
+    std::string condition = emit_condition(s->condition.get());
+    line(fmt::format("if ({}) {{", condition));
+    ++indent;
+    emit_block(s->statements);
+    --indent;
+    // an elif's condition is evaluated in the else of the one before
+    size_t nested = 0;
+    for (const auto &elif : s->elif_statements) {
+        line("} else {");
+        ++indent;
+        ++nested;
+        condition = emit_condition(elif->condition.get());
+        line(fmt::format("if ({}) {{", condition));
+        ++indent;
+        emit_block(elif->statements);
+        --indent;
+    }
+    if (!s->else_statements.empty()) {
+        line("} else {");
+        ++indent;
+        emit_block(s->else_statements);
+        --indent;
+    }
+    line("}");
+    for (; nested > 0; --nested) {
+        --indent;
+        line("}");
+    }
+}
+
+void Transpiler::emit_while_statement(WhileExpr *s) {
+    line("while (true) {");
+    ++indent;
+    std::string condition = emit_condition(s->condition.get());
+    line(fmt::format("if ({}) break;", negated(condition)));
+    emit_block(s->statements);
+    --indent;
+    line("}");
+}
+
+void Transpiler::emit_return(ReturnExpr *s) {
+    Expr *content = s->content.get();
+    bool tail_call =
+        function && content->type == ASTNodeType::FUNCTION_CALL &&
+        ast_cast<CallExpr>(content)->target.kind == Callee::FUNCTION;
+    if (tail_call) {
+        auto call = ast_cast<CallExpr>(content);
+        if (call->target.index != function->slot) {
+            std::string callee = emit_call(call);
+            line("frame.release();");
+            line(fmt::format("return {};", callee));
+            return;
+        }
+        // gifting a call to itself loops with the arguments as the
+        // parameters, like TAIL_CALL the C++ stack doesn't grow
+        std::vector<std::string> args;
+        for (auto &param : call->params) {
+            std::string arg = emit_expr(param.get());
+            std::string t = temp();
+            line(fmt::format("Value {} = {};", t, arg));
+            args.push_back(t);
+        }
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (function->param_types[i] == Annotation::NONE) continue;
+            line(fmt::format("rt.check_type({}, {}, {});",
+                             args[i],
+                             annotation_enum(function->param_types[i]),
+                             quote(function->params[i])));
+        }
+        for (size_t i = 0; i < args.size(); ++i) {
+            line(fmt::format("s[{}] = {};", i, args[i]));
+        }
+        line("goto start;");
+        tail_loop = true;
+        return;
+    }
+    std::string value = emit_expr(content);
+    if (function) {
+        line(fmt::format("return {};", value));
+    } else {
+        // gifting from the top level ends the program
+        line(fmt::format("(void){};", value));
+        line("return;");
+    }
+}
+
+void Transpiler::emit_object_attr_reassign(ObjectAttrReassignExpr *s) {
+    auto dot = ast_cast<DotExpr>(s->head.get());
+    std::string head = emit_expr(dot->head.get());
+    for (size_t i = 0; i + 1 < dot->after.size(); ++i) {
+        head = emit_dot_step(head, dot->after[i].get());
+    }
+    Expr *last = dot->after.back().get();
+    if (last->type == ASTNodeType::FUNCTION_CALL) {
+        throw Error(Error::SYNTAX_ERROR,
+                    "Error: Cannot assign to a method call.");
+    }
+    std::string site = attr_site(last);
+    std::string value = emit_expr(s->right.get());
+    line(fmt::format("rt.set_attr({}, {}, {});", head, site, value));
+}
+
+void Transpiler::emit_index_assign(IndexAssignExpr *s) {
+    std::string container = emit_expr(s->head->container.get());
+    std::string index = emit_expr(s->head->index.get());
+    std::string value = emit_expr(s->right.get());
+    line(fmt::format("rt.set_index({}, {}, {});", container, index, value));
+}
+
+std::string Transpiler::emit_condition(Expr *condition) {
+    if (condition->type == ASTNodeType::UNARY) {
+        auto v = ast_cast<UnaryExpr>(condition);
+        if (v->op == TokenType::NOT) {
+            return negated(emit_condition(v->unary.get()));
+        }
+    }
+    std::string t;
+    if (condition->type == ASTNodeType::BINARY) {
+        auto v = ast_cast<BinaryExpr>(condition);
+        switch (v->op) {
+            case TokenType::AND:
+            case TokenType::OR: {
+                // the right side only runs if the left one didn't decide it
+                std::string left = emit_condition(v->left.get());
+                t = temp();
+                line(fmt::format("bool {} = {};", t, left));
+                line(fmt::format("if ({}) {{",
+                                 v->op == TokenType::AND ? t : negated(t)));
+                ++indent;
+                std::string right = emit_condition(v->right.get());
+                line(fmt::format("{} = {};", t, right));
+                --indent;
+                line("}");
+                return t;
+            }
+            case TokenType::LT:
+            case TokenType::GT:
+            case TokenType::LOT:
+            case TokenType::GOT:
+            case TokenType::EQUALS:
+            case TokenType::NOT_EQUAL: {
+                std::string left = emit_expr(v->left.get());
+                std::string right = emit_expr(v->right.get());
+                t = temp();
+                line(fmt::format("bool {} = rt.compare({}, {}, {});",
+                                 t,
+                                 operator_name(v->op),
+                                 left,
+                                 right));
+                return t;
+            }
+            default:
+                break;
+        }
+    }
+    std::string value = emit_expr(condition);
+    t = temp();
+    line(fmt::format("bool {} = rt.condition({});", t, value));
+    return t;
+}
+
+std::string Transpiler::emit_expr(Expr *expr) {
+    std::string t;
+    switch (expr->type) {
+        case ASTNodeType::LITERAL: {
+            return literal(ast_cast<LiteralExpr>(expr)->value);
+        }
+        case ASTNodeType::LIST: {
+            std::vector<std::string> elements;
+            for (auto &element : ast_cast<ListExpr>(expr)->elements) {
+                elements.push_back(emit_expr(element.get()));
+            }
+            t = temp();
+            line(fmt::format("Value {} = rt.list({{{}}});", t, join(elements)));
+            return t;
+        }
+        case ASTNodeType::SYMBOL: {
+            auto symbol = ast_cast<SymbolExpr>(expr);
+            // nothing in an expression assigns a local, a call may assign
+            // a global though
+            if (!symbol->binding.global) {
+                return fmt::format("s[{}]", symbol->binding.slot);
+            }
+            t = temp();
+            line(fmt::format("Value {} = rt.get_global({});",
+                             t,
+                             globals.slot(symbol->symbol)));
+            return t;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            auto dot = ast_cast<DotExpr>(expr);
+            std::string head = emit_expr(dot->head.get());
+            for (auto &after : dot->after) {
+                head = emit_dot_step(head, after.get());
+            }
+            return head;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(expr);
+            std::string container = emit_expr(v->container.get());
+            std::string index = emit_expr(v->index.get());
+            t = temp();
+            line(fmt::format(
+                "Value {} = rt.get_index({}, {});", t, container, index));
+            return t;
+        }
+        case ASTNodeType::BINARY: {
+            auto v = ast_cast<BinaryExpr>(expr);
+            if (v->op == TokenType::AND || v->op == TokenType::OR) {
+                std::string condition = emit_condition(v);
+                t = temp();
+                line(fmt::format(
+                    "Value {} = Value::boolean({});", t, condition));
+                return t;
+            }
+            ConcatChain chain;
+            if (find_concat_chain(v, chain)) {
+                // see Compiler::compile_concat
+                std::string left = emit_expr(chain.prefix);
+                std::string right = emit_expr(chain.pieces[0]);
+                t = temp();
+                line(fmt::format("Value {} = rt.concat({}, {}, {});",
+                                 t,
+                                 left,
+                                 right,
+                                 chain.size));
+                for (size_t i = 1; i < chain.pieces.size(); ++i) {
+                    std::string piece = emit_expr(chain.pieces[i]);
+                    line(fmt::format(
+                        "{} = rt.add_in_place({}, {});", t, t, piece));
+                }
+                return t;
+            }
+            std::string left = emit_expr(v->left.get());
+            std::string right = emit_expr(v->right.get());
+            t = temp();
+            line(fmt::format("Value {} = rt.binary({}, {}, {});",
+                             t,
+                             operator_name(v->op),
+                             left,
+                             right));
+            return t;
+        }
+        case ASTNodeType::UNARY: {
+            auto v = ast_cast<UnaryExpr>(expr);
+            std::string value = emit_expr(v->unary.get());
+            t = temp();
+            line(fmt::format("Value {} = rt.{}({});",
+                             t,
+                             v->op == TokenType::MINUS ? "negate"
+                                                       : "logical_not",
+                             value));
+            return t;
+        }
+        case ASTNodeType::FUNCTION_CALL: {
+            std::string call = emit_call(ast_cast<CallExpr>(expr));
+            t = temp();
+            line(fmt::format("Value {} = {};", t, call));
+            return t;
+        }
+        case ASTNodeType::OBJECT_INSTANTIATION: {
+            const std::string &name =
+                ast_cast<ObjectInstantiationExpr>(expr)->class_name;
+            t = temp();
+            line(fmt::format("Value {} = rt.new_object({});", t, quote(name)));
+            return t;
+        }
+        default:
+            throw Error(Error::SYNTAX_ERROR,
+                        "Error: Statement used as an expression.");
+    }
+}
+
+std::string Transpiler::emit_call(CallExpr *call) {
+    std::vector<std::string> args;
+    for (auto &param : call->params) {
+        args.push_back(emit_expr(param.get()));
+    }
+    if (call->target.kind == Callee::FUNCTION) {
+        return fmt::format("f{}({})", call->target.index, join(args));
+    }
+    auto [it, added] =
+        native_numbers.emplace(call->target.index, native_names.size());
+    if (added) native_names.push_back(natives[call->target.index].name);
+    return fmt::format("rt.native({}, {{{}}})", it->second, join(args));
+}
+
+std::string Transpiler::emit_dot_step(const std::string &head, Expr *after) {
+    std::string t;
+    if (after->type != ASTNodeType::FUNCTION_CALL) {
+        std::string site = attr_site(after);
+        t = temp();
+        line(fmt::format("Value {} = rt.attr({}, {});", t, head, site));
+        return t;
+    }
+    auto call = ast_cast<CallExpr>(after);
+    std::vector<std::string> args{head};
+    for (auto &param : call->params) {
+        args.push_back(emit_expr(param.get()));
+    }
+    std::string site = fmt::format("cs{}", call_count++);
+    constants += fmt::format(
+        "AotCall {}{{{}}};\n", site, quote(call->callee->symbol));
+    t = temp();
+    line(fmt::format(
+        "Value {} = rt.call_method({}, {{{}}});", t, site, join(args)));
+    return t;
+}
+
+std::string Transpiler::literal(Value value) {
+    switch (value.type()) {
+        case ValueType::NONE:
+            return "Value::none()";
+        case ValueType::BOOL:
+            return value.as_bool() ? "Value::boolean(true)"
+                                   : "Value::boolean(false)";
+        case ValueType::NUMBER: {
+            if (value.is_int()) {
+                return fmt::format("Value::int32({})", value.as_int());
+            }
+            double d = value.as_number();
+            if (std::isnan(d)) return "Value::number(NAN)";
+            if (std::isinf(d)) {
+                return d > 0 ? "Value::number(HUGE_VAL)"
+                             : "Value::number(-HUGE_VAL)";
+            }
+            // hex floats are exact
+            return fmt::format("Value::number({:a})", d);
+        }
+        case ValueType::STRING: {
+            // one constant per literal, like in a chunk
+            const std::string &text = value.as<StringValue>()->value;
+            std::string k = fmt::format("k{}", constant_count++);
+            constants += fmt::format("const Value {} = rt.constant({}, {});\n",
+                                     k,
+                                     quote(text),
+                                     text.size());
+            return k;
+        }
+        default:
+            throw Error(Error::INVALID_ARGUMENT_ERROR, "Invalid literal type");
+    }
+}
+
+std::string Transpiler::attr_site(Expr *after) {
+    if (after->type != ASTNodeType::SYMBOL) {
+        throw Error(Error::SYNTAX_ERROR,
+                    "Invalid function call dot expression.");
+    }
+    std::string site = fmt::format("at{}", attr_count++);
+    const std::string &name = ast_cast<SymbolExpr>(after)->symbol;
+    constants += fmt::format("AotAttr {}{{{}}};\n", site, quote(name));
+    return site;
+}
+
+std::string Transpiler::temp() {
+    return fmt::format("t{}", temps++);
+}
+
+void Transpiler::line(const std::string &text) {
+    body += std::string(indent * 4, ' ') + text + "\n";
+}
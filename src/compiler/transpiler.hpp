@@ -0,0 +1,82 @@
+#ifndef COMPILER_TRANSPILER_HPP
+#define COMPILER_TRANSPILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "compiler/resolver.hpp"
+#include "runtime/natives.hpp"
+#include "util/util.hpp"
+
+// translates a program into a standalone C++20 file for `choco --emit-cpp`
+// instead of compiling it to bytecode. The AST goes through the same
+// Optimizer and Resolver as in Interpreter::eval(), then every confection
+// becomes a C++ function on the frame slots the Resolver gave it and every
+// subexpression a temporary, so things run in the order the VM runs them.
+// The file is built against the runtime library (runtime/aot.hpp)
+class Transpiler {
+  public:
+    Transpiler();
+    std::string transpile(std::vector<uptr<Statement>> &ast);
+
+  private:
+    // statements, written to body
+    void emit_statement(Statement *statement);
+    void emit_block(const std::vector<uptr<Statement>> &statements);
+    void emit_variable_declaration(VariableDeclaration *v);
+    void emit_if_statement(IfExpr *s);
+    void emit_while_statement(WhileExpr *s);
+    void emit_return(ReturnExpr *s);
+    void emit_object_attr_reassign(ObjectAttrReassignExpr *s);
+    void emit_index_assign(IndexAssignExpr *s);
+
+    // writes the code that evaluates expr and returns a C++ expression for
+    // its value that later code can't change
+    std::string emit_expr(Expr *expr);
+    // the C++ bool a branch on condition takes, see Compiler::compile_branch
+    std::string emit_condition(Expr *condition);
+    // the C++ call after its arguments were evaluated
+    std::string emit_call(CallExpr *call);
+    // the attribute load or method call after on the value head
+    std::string emit_dot_step(const std::string &head, Expr *after);
+    std::string literal(Value value);
+    std::string attr_site(Expr *after);
+
+    // the definitions that are written out once main is done
+    std::string emit_function(FunctionDefExpr *s);
+    std::string emit_class(ClassDefinitionExpr *s, size_t index);
+
+    std::string temp();
+    void line(const std::string &text);
+
+    NativeRegistry natives;
+    GlobalTable globals;
+    FunctionTable functions;
+
+    // the function being written and its indentation
+    std::string body;
+    int indent = 0;
+    uint32_t temps = 0;
+    // the confection being written, nullptr in main or a box
+    FunctionDefExpr *function = nullptr;
+    bool tail_loop = false;
+
+    // declarations of the string literals, attribute and method sites
+    std::string constants;
+    uint32_t constant_count = 0;
+    uint32_t attr_count = 0;
+    uint32_t call_count = 0;
+    // confections in the order their definitions were found, nested ones
+    // are added while the one around them is written
+    std::vector<FunctionDefExpr *> definitions;
+    std::vector<ClassDefinitionExpr *> classes;
+    // the natives called, by registry index, numbered in the order they
+    // were first called
+    std::unordered_map<uint32_t, uint32_t> native_numbers;
+    std::vector<std::string> native_names;
+};
+
+#endif // COMPILER_TRANSPILER_HPP
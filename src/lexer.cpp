@@ -218,6 +218,10 @@ Token Lexer::next() {
                          ">",
                          "<",
                          "!",
+                         "+=",
+                         "-=",
+                         "*=",
+                         "/=",
                          "+",
                          "-",
                          "*",
@@ -234,6 +238,10 @@ Token Lexer::next() {
                                      TokenType::GT,
                                      TokenType::LT,
                                      TokenType::NOT,
+                                     TokenType::PLUS_ASSIGN,
+                                     TokenType::MINUS_ASSIGN,
+                                     TokenType::MUL_ASSIGN,
+                                     TokenType::DIV_ASSIGN,
                                      TokenType::PLUS,
                                      TokenType::MINUS,
                                      TokenType::MUL,
@@ -1,8 +1,10 @@
 #include <fmt/core.h>
 
+#include <charconv>
 #include <string>
 #include <vector>
 
+#include "compiler/transpiler.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
 #include "runtime/interpreter.hpp"
@@ -11,15 +13,65 @@
 #include "util/file.hpp"
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
-        fmt::println("choco <file-name>");
+    InterpreterOptions options;
+    std::string file;
+    bool emit_cpp = false;
+    // where --emit-cpp writes to, stdout if empty
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dump-ast") {
+            options.dump_ast = true;
+        } else if (arg == "--jit") {
+            options.jit = true;
+        } else if (arg == "--no-jit") {
+            options.jit = false;
+        } else if (arg == "--no-inline") {
+            options.inlining.enabled = false;
+        } else if (arg == "--print-inlining") {
+            options.inlining.trace = true;
+        } else if (arg == "--emit-cpp") {
+            emit_cpp = true;
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            std::string depth = argv[++i];
+            auto [end, ec] = std::from_chars(
+                depth.data(), depth.data() + depth.size(), options.max_frames);
+            if (ec != std::errc() || end != depth.data() + depth.size() ||
+                options.max_frames == 0) {
+                file.clear();
+                break;
+            }
+        } else if (arg == "--yield") {
+            options.yield = true;
+        } else if (arg == "--budget" && i + 1 < argc) {
+            std::string budget = argv[++i];
+            auto [end, ec] = std::from_chars(
+                budget.data(), budget.data() + budget.size(), options.budget);
+            if (ec != std::errc() || end != budget.data() + budget.size()) {
+                file.clear();
+                break;
+            }
+        } else if (file.empty()) {
+            file = arg;
+        } else {
+            file.clear();
+            break;
+        }
+    }
+    if (file.empty()) {
+        fmt::println("choco [--dump-ast] [--[no-]jit] [--no-inline] "
+                     "[--print-inlining] [--max-depth <n>] "
+                     "[--budget <n> [--yield]] [--emit-cpp [-o <out.cpp>]] "
+                     "<file-name>");
         return 0;
     }
 
     // if there's an error anywhere we fall back because the interpreter cannot
     // continue at this point
     try {
-        std::string source = load_file(argv[1]);
+        std::string source = load_file(file);
         // tokenize
         Lexer lexer{source};
         lexer.retokenize();
@@ -34,11 +86,25 @@ int main(int argc, char **argv) {
 
         // generate the AST
         Parser parser{tokens};
-        const std::vector<uptr<Statement>> &ast = parser.parse();
+        std::vector<uptr<Statement>> &ast = parser.parse();
+
+        // or translate it to C++ instead
+        if (emit_cpp) {
+            Transpiler transpiler;
+            std::string code = transpiler.transpile(ast);
+            if (output.empty()) {
+                fmt::print("{}", code);
+            } else {
+                save_file(output, code);
+            }
+            return 0;
+        }
 
         // run the interpreter
-        Interpreter choco;
+        Interpreter choco{options};
         choco.eval(ast);
+        // the slices run back to back, a host would do its own work between
+        while (choco.paused()) choco.resume();
 
     } catch (const Error &error) {
         return error.output_error();
@@ -1,5 +1,6 @@
 #include "parser.hpp"
 
+#include <charconv>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -10,6 +11,94 @@
 #include "util/error.hpp"
 #include "util/util.hpp"
 
+// the annotation a TYPE token stands for
+static Annotation annotation_of(Token *token) {
+    std::string type = token->content();
+    if (type == "float" || type == "double") return Annotation::NUMBER;
+    if (type == "int" || type == "short" || type == "long") {
+        return Annotation::WHOLE;
+    }
+    if (type == "unsigned") return Annotation::UNSIGNED;
+    if (type == "char") return Annotation::CHAR;
+    throw Error(Error::SYNTAX_ERROR,
+                fmt::format("'{}' is not a variable type.", type));
+}
+
+// a literal without a decimal point is an int, unless it's too big for one
+static Value number_literal(const std::string &text) {
+    int64_t n;
+    const char *end = text.data() + text.size();
+    auto [ptr, error] = std::from_chars(text.data(), end, n);
+    if (error == std::errc{} && ptr == end) return Value::integer(n);
+    return Value::number(std::stod(text));
+}
+
+// the operator of `+=`, `-=`, `*=` or `/=`, END for anything else
+static TokenType compound_op(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS_ASSIGN:
+            return TokenType::PLUS;
+        case TokenType::MINUS_ASSIGN:
+            return TokenType::MINUS;
+        case TokenType::MUL_ASSIGN:
+            return TokenType::MUL;
+        case TokenType::DIV_ASSIGN:
+            return TokenType::DIV;
+        default:
+            return TokenType::END;
+    }
+}
+
+// `target op= value` is `target = target op value`
+static uptr<Expr> compound_value(uptr<Expr> target, TokenType op,
+                                 uptr<Expr> value) {
+    auto binary_expr = std::make_unique<BinaryExpr>();
+    binary_expr->left = std::move(target);
+    binary_expr->op = op;
+    binary_expr->right = std::move(value);
+    return binary_expr;
+}
+
+// a copy of an assignment target made of symbols, attributes and number
+// subscripts, nullptr for anything else
+static uptr<Expr> clone_target(Expr *expr) {
+    switch (expr->type) {
+        case ASTNodeType::SYMBOL:
+            return std::make_unique<SymbolExpr>(
+                ast_cast<SymbolExpr>(expr)->symbol);
+        case ASTNodeType::LITERAL: {
+            Value value = ast_cast<LiteralExpr>(expr)->value;
+            if (!value.is_number()) return nullptr;
+            auto literal = std::make_unique<LiteralExpr>();
+            literal->value = value;
+            return literal;
+        }
+        case ASTNodeType::DOT_SYMBOL: {
+            auto v = ast_cast<DotExpr>(expr);
+            auto copy = std::make_unique<DotExpr>();
+            copy->head = clone_target(v->head.get());
+            if (copy->head == nullptr) return nullptr;
+            for (const auto &after : v->after) {
+                if (after->type != ASTNodeType::SYMBOL) return nullptr;
+                copy->after.push_back(clone_target(after.get()));
+            }
+            return copy;
+        }
+        case ASTNodeType::INDEX: {
+            auto v = ast_cast<IndexExpr>(expr);
+            auto copy = std::make_unique<IndexExpr>();
+            copy->container = clone_target(v->container.get());
+            copy->index = clone_target(v->index.get());
+            if (copy->container == nullptr || copy->index == nullptr) {
+                return nullptr;
+            }
+            return copy;
+        }
+        default:
+            return nullptr;
+    }
+}
+
 Parser::Parser(const std::vector<Token> &tokens) : tokens(tokens) {}
 
 Parser::~Parser() {}
@@ -34,7 +123,7 @@ bool Parser::match_peek(TokenType type) {
     return peek()->type == type;
 }
 
-const std::vector<uptr<Statement>> &Parser::parse() {
+std::vector<uptr<Statement>> &Parser::parse() {
     while (current()->type != TokenType::END) {
         uptr<Statement> s = declaration();
         // if it's nullptr it's a comment
@@ -83,7 +172,9 @@ uptr<Expr> Parser::declaration() {
         return var_declaration();
     }
     // variable reassignment
-    if (match(TokenType::SYMBOL) && match_peek(TokenType::ASSIGNMENT)) {
+    if (match(TokenType::SYMBOL) &&
+        (match_peek(TokenType::ASSIGNMENT) ||
+         compound_op(peek()->type) != TokenType::END)) {
         advance();
         Token *symbol = previous();
 
@@ -92,8 +183,14 @@ uptr<Expr> Parser::declaration() {
         declaration->name = symbol->content();
         declaration->type = ASTNodeType::VARIABLE_REASSIGN;
 
-        expect(TokenType::ASSIGNMENT);
+        TokenType op = compound_op(current()->type);
+        advance();
         declaration->value = expression();
+        if (op != TokenType::END) {
+            declaration->value = compound_value(
+                std::make_unique<SymbolExpr>(declaration->name), op,
+                std::move(declaration->value));
+        }
         expect(TokenType::SEMICOLON);
 
         return declaration;
@@ -163,7 +260,14 @@ uptr<Expr> Parser::statement() {
         while_stmnt->statements = parse_body();
         return while_stmnt;
     }
-    return expression();
+    auto expr = expression();
+    // a method call on its own: obj.method(...);
+    if (expr->type == ASTNodeType::DOT_SYMBOL &&
+        ast_cast<DotExpr>(expr.get())->after.back()->type ==
+            ASTNodeType::FUNCTION_CALL) {
+        expect(TokenType::SEMICOLON);
+    }
+    return expr;
 }
 
 uptr<Expr> Parser::expression() {
@@ -281,40 +385,63 @@ uptr<Expr> Parser::postfix() {
     // get symbol
     auto left = primary();
 
-    // force dot operator
-    if (!match(TokenType::DOT)) return left;
-
-    advance();
-    auto dot_expr = std::make_unique<DotExpr>();
-    dot_expr->head = std::move(left);
-
-    const auto advance_wrapper = [&]() -> bool {
+    // any mix of .attr and [index] after it
+    while (match(TokenType::DOT) || match(TokenType::OPEN_BRACKET)) {
+        if (match(TokenType::OPEN_BRACKET)) {
+            advance();
+            auto index_expr = std::make_unique<IndexExpr>();
+            index_expr->container = std::move(left);
+            index_expr->index = expression();
+            expect(TokenType::CLOSE_BRACKET);
+            left = std::move(index_expr);
+            continue;
+        }
         advance();
-        return true;
-    };
-
-    do {
+        // a.b.c is one dot expression
+        if (left->type != ASTNodeType::DOT_SYMBOL) {
+            auto dot_expr = std::make_unique<DotExpr>();
+            dot_expr->head = std::move(left);
+            left = std::move(dot_expr);
+        }
         // must be symbol
-        auto left = primary();
-        if (left->type == ASTNodeType::LITERAL)
+        auto attr = primary();
+        if (attr->type == ASTNodeType::LITERAL)
             throw Error(Error::TYPE_ERROR,
                         "Literal Types cannot have postfix '.' operator");
-
-        dot_expr->after.push_back(std::move(left));
-
-    } while (match(TokenType::DOT) && advance_wrapper());
+        ast_cast<DotExpr>(left.get())->after.push_back(std::move(attr));
+    }
 
     // now check if it's an assignment
-    if (match(TokenType::ASSIGNMENT)) {
-        advance();
+    bool target = left->type == ASTNodeType::DOT_SYMBOL ||
+                  left->type == ASTNodeType::INDEX;
+    TokenType op = compound_op(current()->type);
+    if (!target || (!match(TokenType::ASSIGNMENT) && op == TokenType::END)) {
+        return left;
+    }
+    advance();
+    auto right = expression();
+    if (op != TokenType::END) {
+        // the target is loaded again, only a plain chain of symbols and
+        // number subscripts can be without running anything twice
+        auto again = clone_target(left.get());
+        if (again == nullptr) {
+            throw Error(Error::SYNTAX_ERROR,
+                        "Invalid compound assignment target.");
+        }
+        right = compound_value(std::move(again), op, std::move(right));
+    }
+    expect(TokenType::SEMICOLON);
+
+    if (left->type == ASTNodeType::DOT_SYMBOL) {
         auto assignment_expr = std::make_unique<ObjectAttrReassignExpr>();
-        assignment_expr->head = std::move(dot_expr);
-        assignment_expr->right = expression();
-        expect(TokenType::SEMICOLON);
+        assignment_expr->head = std::move(left);
+        assignment_expr->right = std::move(right);
         return assignment_expr;
     }
-
-    return dot_expr;
+    auto assignment_expr = std::make_unique<IndexAssignExpr>();
+    assignment_expr->head.reset(ast_cast<IndexExpr>(left.release()));
+    assignment_expr->right = std::move(right);
+    return assignment_expr;
 }
 
 uptr<Expr> Parser::primary() {
@@ -326,20 +453,21 @@ uptr<Expr> Parser::primary() {
     if (match(TokenType::STRING)) {
         uptr<LiteralExpr> expr = std::make_unique<LiteralExpr>();
         // trim the quotes at the beginning and end
-        expr->value = std::make_unique<StringValue>(
+        expr->object = std::make_unique<StringValue>(
             curr_content.substr(1, curr_content.size() - 2));
+        expr->value = Value::object(expr->object.get());
         advance();
         return expr;
     }
     if (match(TokenType::NUMBER)) {
         uptr<LiteralExpr> expr = std::make_unique<LiteralExpr>();
-        expr->value = std::make_unique<NumValue>(std::stod(curr_content));
+        expr->value = number_literal(curr_content);
         advance();
         return expr;
     }
     if (match(TokenType::BOOLEAN)) {
         uptr<LiteralExpr> expr = std::make_unique<LiteralExpr>();
-        expr->value = std::make_unique<BoolValue>(curr_content == "true");
+        expr->value = Value::boolean(curr_content == "true");
         advance();
         return expr;
     }
@@ -394,10 +522,14 @@ uptr<Expr> Parser::primary() {
 }
 
 uptr<VariableDeclaration> Parser::var_declaration() {
-    Token *symbol = expect(TokenType::SYMBOL);
-
     uptr<VariableDeclaration> declaration =
         std::make_unique<VariableDeclaration>();
+    // `let double x = 0;`
+    if (match(TokenType::TYPE)) {
+        declaration->annotation = annotation_of(current());
+        advance();
+    }
+    Token *symbol = expect(TokenType::SYMBOL);
     declaration->name = symbol->content();
     expect(TokenType::ASSIGNMENT);
 
@@ -440,6 +572,12 @@ uptr<FunctionDefExpr> Parser::function_def() {
     // if there are args
     if (!match(TokenType::CLOSE_PAREN)) {
         do {
+            Annotation type = Annotation::NONE;
+            if (match(TokenType::TYPE)) {
+                type = annotation_of(current());
+                advance();
+            }
+            func_def->param_types.push_back(type);
             expect(TokenType::SYMBOL);
             auto param = previous();
             func_def->params.push_back(param->content());
@@ -460,11 +598,32 @@ uptr<Expr> Parser::class_def() {
     expect(TokenType::OPEN_CURLY);
 
     while (!match(TokenType::CLOSE_CURLY)) {
+        if (match(TokenType::COMMENT)) {
+            advance();
+            continue;
+        }
         // define all the struct vars
         if (match(TokenType::LET)) {
             advance();
             auto var_decl = var_declaration();
+            if (var_decl->annotation != Annotation::NONE) {
+                throw Error(Error::SYNTAX_ERROR,
+                            fmt::format("Attribute '{}' can't have a type.",
+                                        var_decl->name));
+            }
             class_expr->attributes.push_back(std::move(var_decl));
+        } else if (match(TokenType::FUNCTION)) {
+            advance();
+            auto method = function_def();
+            method->name = class_expr->name + "." + method->name;
+            method->params.insert(method->params.begin(), "self");
+            method->param_types.insert(method->param_types.begin(),
+                                       Annotation::NONE);
+            class_expr->methods.push_back(std::move(method));
+        } else {
+            throw Error(Error::SYNTAX_ERROR,
+                        fmt::format("Invalid syntax: '{}'",
+                                    current()->content()));
         }
     }
     advance();
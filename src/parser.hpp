@@ -14,7 +14,8 @@ class Parser {
     Parser(const std::vector<Token> &tokens);
     ~Parser();
 
-    const std::vector<uptr<Statement>> &parse();
+    // the Interpreter's Optimizer rewrites the tree in place
+    std::vector<uptr<Statement>> &parse();
 
   private:
     Token *expect(TokenType type);
@@ -0,0 +1,253 @@
+#include "aot.hpp"
+
+#include <fmt/core.h>
+
+#if __has_include(<pthread.h>)
+#include <pthread.h>
+#define CHOCO_AOT_PTHREAD 1
+#else
+#define CHOCO_AOT_PTHREAD 0
+#endif
+
+#include "runtime/graphics.hpp"
+
+AotClass::AotClass(const char *name,
+                   std::initializer_list<const char *> attributes,
+                   Value (*construct)(),
+                   std::initializer_list<AotMethod> methods)
+    : name(name), construct(construct), methods(methods) {
+    for (const char *attribute : attributes) {
+        shape.add(attribute);
+    }
+    for (const AotMethod &method : methods) {
+        shape.methods[method.name] = method.slot;
+    }
+}
+
+AotRuntime::AotRuntime(std::initializer_list<const char *> globals,
+                       std::initializer_list<const char *> functions,
+                       std::initializer_list<const char *> natives)
+    : global_names(globals.begin(), globals.end()),
+      globals(globals.size(), Value::undefined()),
+      function_names(functions.begin(), functions.end()),
+      defined(functions.size(), false),
+      methods(functions.size(), nullptr) {
+    // the same builtins the Interpreter has, found by name since the
+    // program only numbers the ones it calls
+    NativeRegistry registry;
+    define_core_natives(registry);
+    define_graphics_natives(registry);
+    for (const char *name : natives) {
+        int64_t index = registry.find(name);
+        if (index < 0) {
+            throw Error(
+                Error::NAME_ERROR,
+                fmt::format("Error: Function '{}' does not exist.", name));
+        }
+        this->natives.push_back(registry[index].fn);
+    }
+}
+
+namespace {
+
+struct Entry {
+    void (*run)();
+    Error::Code code = Error::OK;
+};
+
+void *run_program(void *data) {
+    Entry *entry = (Entry *)data;
+    try {
+        entry->run();
+    } catch (const Error &error) {
+        entry->code = error.output_error();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int AotRuntime::run(void (*program)()) {
+    Entry state{program};
+#if CHOCO_AOT_PTHREAD
+    // every choco call is a C++ call here, give the deepest recursion the
+    // VM allows room on a stack of its own
+    constexpr size_t FRAME_SIZE = 4096;
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, max_frames * FRAME_SIZE);
+    bool started = pthread_create(&thread, &attr, run_program, &state) == 0;
+    pthread_attr_destroy(&attr);
+    if (started) {
+        pthread_join(thread, nullptr);
+        return state.code;
+    }
+#endif
+    run_program(&state);
+    return state.code;
+}
+
+void AotRuntime::set_global(uint32_t slot, Value value) {
+    if (globals[slot].is_undefined()) {
+        throw Error(Error::NAME_ERROR,
+                    fmt::format("Error: Variable name '{}' does not exist!\n",
+                                global_names[slot]));
+    }
+    globals[slot] = value;
+}
+
+void AotRuntime::define_global(uint32_t slot, Value value) {
+    if (!globals[slot].is_undefined()) {
+        throw Error(Error::NAME_ERROR,
+                    fmt::format("Error: Variable name '{}' already declared.",
+                                global_names[slot]));
+    }
+    globals[slot] = value;
+}
+
+void AotRuntime::define_class(AotClass &box) {
+    if (!classes.emplace(box.name, &box).second) {
+        throw Error(Error::NAME_ERROR,
+                    fmt::format("Error: Class name '{}' already declared.",
+                                box.name));
+    }
+    for (const AotMethod &method : box.methods) {
+        methods[method.slot] = &method;
+    }
+}
+
+Value AotRuntime::new_object(const char *class_name) {
+    auto it = classes.find(class_name);
+    if (it == classes.end()) {
+        throw Error(
+            Error::NAME_ERROR,
+            fmt::format("Error: Class name '{}' does not exist.", class_name));
+    }
+    return it->second->construct();
+}
+
+Value AotRuntime::build_object(const AotClass &box,
+                               std::initializer_list<Value> values) {
+    auto obj = memory.get<ObjectValue>(&box.shape);
+    size_t i = 0;
+    for (Value value : values) {
+        obj->slots[i++] = copy(memory, value);
+    }
+    return Value::object(obj);
+}
+
+Value &AotRuntime::attr_miss(Value head, AotAttr &site) {
+    if (head.type() != ValueType::OBJECT) {
+        throw Error(Error::TYPE_ERROR,
+                    fmt::format("Error: Cannot access '{}' of a non-object.",
+                                site.name));
+    }
+    ObjectValue *obj = head.as<ObjectValue>();
+    int64_t slot = obj->shape->find(site.name);
+    if (slot < 0) {
+        throw Error(Error::NAME_ERROR,
+                    "Failed to find symbol after dot expression.");
+    }
+    site.shape = obj->shape;
+    site.slot = slot;
+    return obj->slots[slot];
+}
+
+Value AotRuntime::method_miss(AotCall &site,
+                              std::initializer_list<Value> args) {
+    Value receiver = *args.begin();
+    if (receiver.type() != ValueType::OBJECT) {
+        throw Error(Error::TYPE_ERROR,
+                    fmt::format("Error: Cannot call '{}' of a non-object.",
+                                site.name));
+    }
+    const Shape *shape = receiver.as<ObjectValue>()->shape;
+    auto it = shape->methods.find(site.name);
+    if (it == shape->methods.end()) {
+        throw Error(
+            Error::NAME_ERROR,
+            fmt::format("Error: Function '{}' does not exist.", site.name));
+    }
+    const AotMethod *method = methods[it->second];
+    if (method->arity != args.size()) {
+        throw Error(Error::INVALID_ARGUMENT_ERROR,
+                    fmt::format("Error: Function definition '{}' has {} "
+                                "parameters but got {} arguments.",
+                                function_names[method->slot],
+                                method->arity - 1,
+                                args.size() - 1));
+    }
+    site.shape = shape;
+    site.method = method;
+    return method->fn(args.begin());
+}
+
+void AotRuntime::set_attr(Value head, AotAttr &site, Value value) {
+    assign_attr(attr(head, site), value);
+}
+
+void AotRuntime::assign_attr(Value &slot, Value value) {
+    // an attribute keeps its type once it holds a value
+    if (!slot.is_none() && slot.type() != value.type()) {
+        throw Error(Error::TYPE_ERROR, "Cannot assign different types");
+    }
+    slot = copy(memory, value);
+}
+
+Value AotRuntime::list(std::initializer_list<Value> values) {
+    auto list = memory.get<ListValue>();
+    list->value.assign(values.begin(), values.end());
+    return Value::object(list);
+}
+
+Value AotRuntime::constant(const char *text, size_t size) {
+    return Value::object(memory.get<StringValue>(std::string(text, size)));
+}
+
+Value AotRuntime::negate(Value value) {
+    if (!value.is_number()) {
+        throw Error(Error::TYPE_ERROR, "Error: Invalid operation 'Minus'.");
+    }
+    return value.is_int() ? Value::integer(-(int64_t)value.as_int())
+                          : Value::number(-value.as_number());
+}
+
+Value AotRuntime::logical_not(Value value) {
+    if (!value.is_bool()) {
+        throw Error(Error::TYPE_ERROR, "Error: Invalid operation 'Not'.");
+    }
+    return Value::boolean(!value.as_bool());
+}
+
+void AotRuntime::recursion_error(const char *name) {
+    throw Error(Error::RECURSION_ERROR,
+                fmt::format("Error: Maximum recursion depth of {} "
+                            "exceeded in '{}'.",
+                            max_frames,
+                            name));
+}
+
+void AotRuntime::undefined_global(uint32_t slot) {
+    throw Error(
+        Error::NAME_ERROR,
+        fmt::format("Variable '{}' is not in scope and does not exist!",
+                    global_names[slot]));
+}
+
+void AotRuntime::missing_function(uint32_t slot) {
+    throw Error(Error::NAME_ERROR,
+                fmt::format("Error: Function '{}' does not exist.",
+                            function_names[slot]));
+}
+
+void AotRuntime::condition_error() {
+    throw Error(Error::TYPE_ERROR, "Error: Condition must be a boolean.");
+}
+
+void AotRuntime::type_error(Annotation type, const char *name) {
+    throw Error(Error::TYPE_ERROR,
+                fmt::format("Error: '{}' can only hold a {}.",
+                            name,
+                            annotation_name(type)));
+}
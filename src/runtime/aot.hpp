@@ -0,0 +1,203 @@
+#ifndef RUNTIME_AOT_HPP
+#define RUNTIME_AOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime/memory.hpp"
+#include "runtime/natives.hpp"
+#include "runtime/operators.hpp"
+#include "runtime/value.hpp"
+#include "token.hpp"
+#include "util/error.hpp"
+
+// what the C++ written by `choco --emit-cpp` (see Transpiler) links against.
+// Values, operators and natives are the VM's own and every error is raised
+// with the VM's message, so a compiled script prints what the interpreter
+// would
+
+// the inline cache of one attribute site, like AttrCache
+struct AotAttr {
+    const char *name;
+    const Shape *shape = nullptr;
+    uint32_t slot = 0;
+};
+
+// a method of a box, fn calls its confection with the instance and the
+// arguments in args
+struct AotMethod {
+    const char *name;
+    uint32_t slot;
+    // the parameters, self included
+    uint32_t arity;
+    Value (*fn)(const Value *args);
+};
+
+// the inline cache of one `obj.name(...)` site, like MethodCache
+struct AotCall {
+    const char *name;
+    const Shape *shape = nullptr;
+    const AotMethod *method = nullptr;
+};
+
+// a box, construct evaluates its default values in a frame of its own
+struct AotClass {
+    AotClass(const char *name, std::initializer_list<const char *> attributes,
+             Value (*construct)(),
+             std::initializer_list<AotMethod> methods = {});
+
+    std::string name;
+    Shape shape;
+    Value (*construct)();
+    std::vector<AotMethod> methods;
+};
+
+class AotRuntime {
+  public:
+    // the names of the program's global slots, confection slots and the
+    // natives it calls, in the order the generated code numbers them
+    AotRuntime(std::initializer_list<const char *> globals,
+               std::initializer_list<const char *> functions,
+               std::initializer_list<const char *> natives);
+
+    // runs program on a thread with enough stack for max_frames nested
+    // calls, returns the code of the error it stopped with like main.cpp
+    int run(void (*program)());
+
+    // variables, confections and boxes
+    Value get_global(uint32_t slot) {
+        Value value = globals[slot];
+        if (value.is_undefined()) undefined_global(slot);
+        return value;
+    }
+    void set_global(uint32_t slot, Value value);
+    void define_global(uint32_t slot, Value value);
+    void define_function(uint32_t slot) {
+        defined[slot] = true;
+    }
+    // NAME_ERROR unless the definition of the confection already ran
+    void check_function(uint32_t slot) {
+        if (!defined[slot]) missing_function(slot);
+    }
+    void define_class(AotClass &box);
+    Value new_object(const char *class_name);
+    // the instance of box holding values, strings are copied
+    Value build_object(const AotClass &box,
+                       std::initializer_list<Value> values);
+
+    // objects and lists
+    Value &attr(Value head, AotAttr &site) {
+        if (head.is_object() && head.as_object()->type == ValueType::OBJECT) {
+            ObjectValue *obj = head.as<ObjectValue>();
+            if (obj->shape == site.shape) return obj->slots[site.slot];
+        }
+        return attr_miss(head, site);
+    }
+    void set_attr(Value head, AotAttr &site, Value value);
+    // args holds the instance then the arguments
+    Value call_method(AotCall &site, std::initializer_list<Value> args) {
+        Value receiver = *args.begin();
+        if (receiver.is_object() &&
+            receiver.as_object()->type == ValueType::OBJECT &&
+            receiver.as<ObjectValue>()->shape == site.shape) {
+            return site.method->fn(args.begin());
+        }
+        return method_miss(site, args);
+    }
+    // `obj.attr = value` for an attribute in slot, also one kept in a local
+    void assign_attr(Value &slot, Value value);
+    Value list(std::initializer_list<Value> values);
+    Value get_index(Value container, Value index) {
+        return ::get_index(memory, container, index);
+    }
+    void set_index(Value container, Value index, Value value) {
+        ::set_index(memory, container, index, value);
+    }
+    // a string literal, made once like the constants of a chunk
+    Value constant(const char *text, size_t size);
+
+    // operators
+    Value binary(TokenType op, Value left, Value right) {
+        Value result;
+        if (left.is_int() && right.is_int() &&
+            int_op(op, left.as_int(), right.as_int(), result)) [[likely]] {
+            return result;
+        }
+        return binary_op(memory, op, left, right);
+    }
+    Value add_in_place(Value left, Value right) {
+        return ::add_in_place(memory, left, right);
+    }
+    Value concat(Value left, Value right, size_t size) {
+        return ::concat(memory, left, right, size);
+    }
+    bool compare(TokenType op, Value left, Value right) {
+        return binary(op, left, right).as_bool();
+    }
+    Value negate(Value value);
+    Value logical_not(Value value);
+    bool condition(Value value) {
+        if (!value.is_bool()) condition_error();
+        return value.as_bool();
+    }
+    // TYPE_ERROR unless value fits the annotation of the variable name
+    void check_type(Value value, Annotation type, const char *name) {
+        if (!fits(type, value)) type_error(type, name);
+    }
+
+    Value native(uint32_t index, std::initializer_list<Value> args) {
+        return natives[index](memory, {args.begin(), args.size()});
+    }
+
+    Memory memory;
+    // frames in use, the program itself is the first like in the VM
+    size_t depth = 1;
+    size_t max_frames = 1 << 16;
+    [[noreturn]] void recursion_error(const char *name);
+
+  private:
+    Value &attr_miss(Value head, AotAttr &site);
+    Value method_miss(AotCall &site, std::initializer_list<Value> args);
+    [[noreturn]] void undefined_global(uint32_t slot);
+    [[noreturn]] void missing_function(uint32_t slot);
+    [[noreturn]] void condition_error();
+    [[noreturn]] void type_error(Annotation type, const char *name);
+
+    std::vector<std::string> global_names;
+    // Value::undefined() until the declaration runs
+    std::vector<Value> globals;
+    std::vector<std::string> function_names;
+    std::vector<bool> defined;
+    std::unordered_map<std::string, AotClass *> classes;
+    // by confection slot, nullptr for the ones that aren't methods
+    std::vector<const AotMethod *> methods;
+    std::vector<NativeFn> natives;
+};
+
+// one call of a confection or a box constructor, counted like a CallFrame so
+// the recursion limit is the VM's
+class AotFrame {
+  public:
+    AotFrame(AotRuntime &rt, const char *name) : rt(rt) {
+        if (rt.depth == rt.max_frames) rt.recursion_error(name);
+        ++rt.depth;
+    }
+    ~AotFrame() {
+        if (!released) --rt.depth;
+    }
+    // a tail call hands the frame over to the confection it gifts
+    void release() {
+        --rt.depth;
+        released = true;
+    }
+
+  private:
+    AotRuntime &rt;
+    bool released = false;
+};
+
+#endif // RUNTIME_AOT_HPP
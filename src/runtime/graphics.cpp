@@ -6,82 +6,62 @@
 #include "raylib.h"
 #include "runtime/value.hpp"
 
-LiteralValue *init_window(Memory &memory,
-                          const std::vector<LiteralValue *> &args) {
-    expect_args(args, 3);
-
+Value init_window(Memory &, std::span<const Value> args) {
     InitWindow(
         as_double(args[0]), as_double(args[1]), as_string(args[2]).c_str());
     SetTargetFPS(60);
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *close_window(Memory &memory,
-                           const std::vector<LiteralValue *> &args) {
-    expect_args(args, 0);
+Value close_window(Memory &, std::span<const Value>) {
     CloseWindow();
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *window_should_close(Memory &memory,
-                                  const std::vector<LiteralValue *> &args) {
-    expect_args(args, 0);
-    return memory.get<BoolValue>(WindowShouldClose());
+Value window_should_close(Memory &, std::span<const Value>) {
+    return Value::boolean(WindowShouldClose());
 }
 
-LiteralValue *begin_drawing(Memory &memory,
-                            const std::vector<LiteralValue *> &args) {
-    expect_args(args, 0);
+Value begin_drawing(Memory &, std::span<const Value>) {
     BeginDrawing();
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *end_drawing(Memory &memory,
-                          const std::vector<LiteralValue *> &args) {
-    expect_args(args, 0);
+Value end_drawing(Memory &, std::span<const Value>) {
     EndDrawing();
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *clear_background(Memory &memory,
-                               const std::vector<LiteralValue *> &args) {
-    expect_args(args, 1);
-    const std::string &color = static_cast<StringValue *>(args[0])->value;
+Value clear_background(Memory &, std::span<const Value> args) {
+    const std::string &color = as_string(args[0]);
     ClearBackground(str_to_color(color));
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *draw_rectangle(Memory &memory,
-                             const std::vector<LiteralValue *> &args) {
-    expect_args(args, 5);
-
+Value draw_rectangle(Memory &, std::span<const Value> args) {
     DrawRectangle(as_double(args[0]),
                   as_double(args[1]),
                   as_double(args[2]),
                   as_double(args[3]),
                   str_to_color(as_string(args[4])));
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *draw_circle(Memory &memory,
-                          const std::vector<LiteralValue *> &args) {
-    expect_args(args, 4);
+Value draw_circle(Memory &, std::span<const Value> args) {
     DrawCircleV({(float)as_double(args[0]), (float)as_double(args[1])},
                 as_double(args[2]),
                 str_to_color(as_string(args[3])));
-    return nullptr;
+    return Value::none();
 }
 
-LiteralValue *draw_text(Memory &memory,
-                        const std::vector<LiteralValue *> &args) {
-    expect_args(args, 5);
+Value draw_text(Memory &, std::span<const Value> args) {
     const std::string &text = as_string(args[0]);
     DrawText(text.c_str(),
              as_double(args[1]),
              as_double(args[2]),
              as_double(args[3]),
              str_to_color(as_string(args[4])));
-    return nullptr;
+    return Value::none();
 }
 
 std::unordered_map<std::string, int> key_codes = {
@@ -91,21 +71,9 @@ std::unordered_map<std::string, int> key_codes = {
     {"right", KEY_RIGHT},
 };
 
-LiteralValue *is_key_down(Memory &memory,
-                          const std::vector<LiteralValue *> &args) {
-    expect_args(args, 1);
+Value is_key_down(Memory &, std::span<const Value> args) {
     const std::string &key = as_string(args[0]);
-    return memory.get<BoolValue>(IsKeyDown(key_codes[key]));
-}
-
-void expect_args(const std::vector<LiteralValue *> &args, size_t count) {
-    if (args.size() != count) {
-        fmt::println("UH OH");
-        throw Error(
-            Error::ARGUMENT_ERROR,
-            fmt::format(
-                "Expected {} arguments but got {}.", count, args.size()));
-    }
+    return Value::boolean(IsKeyDown(key_codes[key]));
 }
 
 std::unordered_map<std::string, Color> color_map = {
@@ -126,3 +94,16 @@ Color str_to_color(const std::string &color) {
     }
     return BLACK;
 }
+
+void define_graphics_natives(NativeRegistry &registry) {
+    registry.define("init_window", init_window, 3);
+    registry.define("close_window", close_window, 0);
+    registry.define("window_should_close", window_should_close, 0);
+    registry.define("begin_drawing", begin_drawing, 0);
+    registry.define("end_drawing", end_drawing, 0);
+    registry.define("clear_background", clear_background, 1);
+    registry.define("draw_rectangle", draw_rectangle, 5);
+    registry.define("draw_circle", draw_circle, 4);
+    registry.define("draw_text", draw_text, 5);
+    registry.define("is_key_down", is_key_down, 1);
+}
@@ -3,39 +3,31 @@
 
 #include <raylib.h>
 
+#include <span>
 #include <string>
-#include <vector>
 
 #include "runtime/memory.hpp"
+#include "runtime/natives.hpp"
 #include "runtime/value.hpp"
 #include "util/error.hpp"
 
-LiteralValue *init_window(Memory &memory,
-                          const std::vector<LiteralValue *> &args);
-LiteralValue *close_window(Memory &memory,
-                           const std::vector<LiteralValue *> &args);
-LiteralValue *window_should_close(Memory &memory,
-                                  const std::vector<LiteralValue *> &args);
-LiteralValue *begin_drawing(Memory &memory,
-                            const std::vector<LiteralValue *> &args);
-LiteralValue *end_drawing(Memory &memory,
-                          const std::vector<LiteralValue *> &args);
-LiteralValue *clear_background(Memory &memory,
-                               const std::vector<LiteralValue *> &args);
+Value init_window(Memory &memory, std::span<const Value> args);
+Value close_window(Memory &memory, std::span<const Value> args);
+Value window_should_close(Memory &memory, std::span<const Value> args);
+Value begin_drawing(Memory &memory, std::span<const Value> args);
+Value end_drawing(Memory &memory, std::span<const Value> args);
+Value clear_background(Memory &memory, std::span<const Value> args);
 // drawing funcs
-LiteralValue *draw_rectangle(Memory &memory,
-                             const std::vector<LiteralValue *> &args);
-LiteralValue *draw_circle(Memory &memory,
-                          const std::vector<LiteralValue *> &args);
-LiteralValue *draw_text(Memory &memory,
-                        const std::vector<LiteralValue *> &args);
+Value draw_rectangle(Memory &memory, std::span<const Value> args);
+Value draw_circle(Memory &memory, std::span<const Value> args);
+Value draw_text(Memory &memory, std::span<const Value> args);
 
 // input funcs
-LiteralValue *is_key_down(Memory &memory,
-                          const std::vector<LiteralValue *> &args);
-
-void expect_args(const std::vector<LiteralValue *> &args, size_t count);
+Value is_key_down(Memory &memory, std::span<const Value> args);
 
 Color str_to_color(const std::string &color);
 
+// raylib window, drawing and input builtins
+void define_graphics_natives(NativeRegistry &registry);
+
 #endif // RUNTIME_GRAPHICS_HPP
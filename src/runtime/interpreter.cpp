@@ -4,13 +4,16 @@
 #include <raylib.h>
 
 #include <algorithm>
-#include <cmath>
-#include <iostream>
 #include <memory>
+#include <span>
 #include <string>
 
-#include "ast.hpp"
+#include "compiler/bytecode.hpp"
+#include "compiler/compiler.hpp"
+#include "compiler/optimizer.hpp"
+#include "compiler/resolver.hpp"
 #include "runtime/graphics.hpp"
+#include "runtime/operators.hpp"
 #include "runtime/runtime.hpp"
 #include "runtime/scope.hpp"
 #include "token.hpp"
@@ -18,693 +21,638 @@
 #include "util/util.hpp"
 #include "value.hpp"
 
-LiteralValue *copy(Memory &memory, LiteralValue *s) {
-    switch (s->type) {
-        case ValueType::NUMBER: {
-            return memory.get<NumValue>(as_double(s));
-        }
-        case ValueType::BOOL: {
-            return memory.get<BoolValue>(as_bool(s));
-        }
-        case ValueType::STRING: {
-            return memory.get<StringValue>(as_string(s));
-        }
-        // list and objects are references
-        case ValueType::LIST: {
-            return s;
-        }
-        case ValueType::OBJECT: {
-            return s;
-        }
-    }
+// threaded dispatch needs the GNU labels-as-values extension, otherwise
+// (or with -DCHOCO_NO_COMPUTED_GOTO) fall back to a switch
+#if defined(__GNUC__) && !defined(CHOCO_NO_COMPUTED_GOTO)
+#define CHOCO_COMPUTED_GOTO 1
+#else
+#define CHOCO_COMPUTED_GOTO 0
+#endif
+
+// the operators from ADD to NOT_EQUAL, in opcode order
+static constexpr TokenType binary_ops[] = {TokenType::PLUS,
+                                           TokenType::MINUS,
+                                           TokenType::MUL,
+                                           TokenType::DIV,
+                                           TokenType::LT,
+                                           TokenType::GT,
+                                           TokenType::LOT,
+                                           TokenType::GOT,
+                                           TokenType::EQUALS,
+                                           TokenType::NOT_EQUAL};
+
+Interpreter::Interpreter(InterpreterOptions options) : options(options) {
+    define_core_natives(natives);
+    define_graphics_natives(natives);
+    // reserved up front so calls at ordinary depths don't allocate. deep
+    // recursion (up to max_frames) grows both vectors, frames and slots are
+    // found by index so nothing points into them across a call
+    stack.reserve(STACK_SIZE);
+    frames.reserve(std::min(options.max_frames, FRAMES_RESERVED));
+    if (options.budget > 0) this->options.jit = false;
 }
 
-Interpreter::Interpreter() {}
-
-void Interpreter::eval(const std::vector<uptr<Statement>> &ast) {
-    for (const auto &s : ast) {
-        evaluate(s.get(), &global_scope);
-    }
+void Interpreter::eval(std::vector<uptr<Statement>> &ast) {
+    if (options.dump_ast) {
+        fmt::print("AST before optimization:\n{}", dump_ast(ast));
+    }
+    Optimizer optimizer{globals, natives};
+    optimizer.optimize(ast);
+    if (options.dump_ast) {
+        fmt::print("AST after optimization:\n{}", dump_ast(ast));
+    }
+
+    Resolver resolver{globals, functions, natives};
+    uint32_t main_slots = resolver.resolve(ast);
+    // later programs may only read the globals propagated into this one
+    for (const auto &[name, value] : optimizer.propagated()) {
+        globals.constants.insert(name);
+    }
+    for (const auto &[name, type] : resolver.global_types()) {
+        globals.types[name] = type;
+    }
+    Compiler compiler{memory, globals, options.inlining};
+    programs.push_back(compiler.compile(ast, main_slots));
+    global_values.resize(globals.names.size(), Value::undefined());
+    function_values.resize(functions.names.size(), nullptr);
+    // a previous run may have been aborted by an error
+    stack.clear();
+    frames.clear();
+    suspended = false;
+    refuel();
+    const Function &main = programs.back()->main;
+    push_frame(&main, 0);
+    frames.back().ip = main.chunk.code.data();
+    run(0);
 }
 
-LiteralValue *Interpreter::evaluate(Statement *statement, Scope *scope) {
-    switch (statement->type) {
-        case ASTNodeType::VARIABLE_REASSIGN:
-        case ASTNodeType::VARIABLE_DECLARATION: {
-            VariableDeclaration *v =
-                dynamic_cast<VariableDeclaration *>(statement);
-            return evaluate_variable_declaration(v, scope);
-        }
-        case ASTNodeType::FUNCTION_CALL: {
-            CallExpr *v = dynamic_cast<CallExpr *>(statement);
-            return evaluate_function_call(v, scope);
-        }
-        case ASTNodeType::IF_STATEMENT: {
-            IfExpr *v = dynamic_cast<IfExpr *>(statement);
-            return evaluate_if_statement(v, scope);
-        }
-        case ASTNodeType::BINARY: {
-            BinaryExpr *v = dynamic_cast<BinaryExpr *>(statement);
-            return evaluate_binary_expr(v, scope);
-        }
-        case ASTNodeType::WHILE_STATEMENT: {
-            WhileExpr *v = dynamic_cast<WhileExpr *>(statement);
-            return evaluate_while_statement(v, scope);
-        }
-        case ASTNodeType::FUNCTION_DEFINITION: {
-            FunctionDefExpr *v = dynamic_cast<FunctionDefExpr *>(statement);
-            return evaluate_function_definition(v, scope);
-        }
-        case ASTNodeType::RETURN_STATEMENT: {
-            ReturnExpr *v = dynamic_cast<ReturnExpr *>(statement);
-            return evaluate_return_statement(v, scope);
-        }
-        case ASTNodeType::CLASS_DEFINITION: {
-            ClassDefinitionExpr *v =
-                dynamic_cast<ClassDefinitionExpr *>(statement);
-            return evaluate_class_definition(v, scope);
-        }
-        case ASTNodeType::OBJECT_ATTR_REASSIGN: {
-            ObjectAttrReassignExpr *v =
-                dynamic_cast<ObjectAttrReassignExpr *>(statement);
-            return evaluate_object_attr_reassign(v, scope);
-        }
-        case ASTNodeType::LIST: {
-            ListExpr *v = dynamic_cast<ListExpr *>(statement);
-            return evaluate_list(v, scope);
-        }
-    }
-    return nullptr;
-    UNIMPLEMENTED();
+void Interpreter::resume() {
+    if (!suspended) return;
+    suspended = false;
+    refuel();
+    run(0);
 }
 
-LiteralValue *Interpreter::evaluate_variable_declaration(VariableDeclaration *v,
-                                                         Scope *scope) {
-    // should have caught all syntax/grammar errors
-    const auto &name = v->name;
-    if (v->type == ASTNodeType::VARIABLE_DECLARATION) {
-        if (!scope->runtime.var_exists(name)) {
-            scope->runtime.var_define(name,
-                                      evaluate_expr(v->value.get(), scope));
-            return nullptr;
-        }
-        throw Error(
-            Error::NAME_ERROR,
-            fmt::format("Error: Variable name '{}' already declared.", name));
+void Interpreter::out_of_budget() {
+    if (!options.yield) {
+        throw Error(Error::TIMEOUT_ERROR,
+                    fmt::format("Error: Budget of {} loop iterations and "
+                                "calls exhausted.",
+                                options.budget));
     }
-    // variable reassignment
-    else {
-        // track the original scope for evaluation of expression
-        Scope *curr_scope = scope;
-        while (!scope->runtime.var_exists(name)) {
-            if (scope->parent != nullptr) {
-                scope = scope->parent;
-            } else {
-                throw Error(
-                    Error::NAME_ERROR,
-                    fmt::format("Error: Variable name '{}' does not exist!\n",
-                                name));
-            }
-        }
-        scope->runtime.var_define(name,
-                                  evaluate_expr(v->value.get(), curr_scope));
-    }
-    return nullptr;
+    suspended = true;
 }
 
-LiteralValue *Interpreter::evaluate_function_call(CallExpr *s, Scope *scope) {
-    // check if function name is defined in STD spec
-    if (s->callee->symbol == "print") {
-        return print(s, scope);
-    }
-    if (s->callee->symbol == "input") {
-        return input(s, scope);
-    }
-    std::vector<LiteralValue *> args;
-    std::for_each(s->params.begin(),
-                  s->params.end(),
-                  [&args, this, &scope](uptr<Expr> &expr) {
-                      args.push_back(evaluate_expr(expr.get(), scope));
-                  });
-
-    args.reserve(s->params.size());
-    // math funcs
-    if (s->callee->symbol == "abs") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::abs(as_double(args[0])));
-    }
-    if (s->callee->symbol == "sign") {
-        expect_args(args, 1);
-        double v = as_double(args[0]);
-        return memory.get<NumValue>(v / std::abs(v));
-    }
-    if (s->callee->symbol == "pow") {
-        expect_args(args, 2);
-        return memory.get<NumValue>(
-            std::pow(as_double(args[0]), as_double(args[1])));
-    }
-    if (s->callee->symbol == "sin") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::sin(as_double(args[0])));
-    }
-    if (s->callee->symbol == "cos") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::cos(as_double(args[0])));
-    }
-    if (s->callee->symbol == "tan") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::tan(as_double(args[0])));
-    }
-    if (s->callee->symbol == "sqrt") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::sqrt(as_double(args[0])));
-    }
-    if (s->callee->symbol == "round") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::round(as_double(args[0])));
-    }
-    if (s->callee->symbol == "ceil") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::ceil(as_double(args[0])));
-    }
-    if (s->callee->symbol == "floor") {
-        expect_args(args, 1);
-        return memory.get<NumValue>(std::floor(as_double(args[0])));
-    }
-    // array/string methods
-    if (s->callee->symbol == "len") {
-        expect_args(args, 1);
-        auto v = args[0];
-        if (v->type == ValueType::LIST)
-            return memory.get<NumValue>(
-                static_cast<ListValue *>(v)->value.size());
-        if (v->type == ValueType::STRING)
-            return memory.get<NumValue>(
-                static_cast<StringValue *>(v)->value.size());
-        throw Error(Error::INVALID_ARGUMENT_ERROR,
-                    "Expected list or string type.");
-    }
-    if (s->callee->symbol == "get") {
-        expect_args(args, 2);
-        auto container = args[0];
-        int idx = (int)as_double(args[1]);
-        if (container->type == ValueType::LIST)
-            return static_cast<ListValue *>(container)->value[idx];
-        if (container->type == ValueType::STRING) {
-            std::string str =
-                std::string{static_cast<StringValue *>(container)->value[idx]};
-            return memory.get<StringValue>(str);
-        }
-        throw Error(Error::INVALID_ARGUMENT_ERROR,
-                    "Expected list or string type.");
-    }
-    if (s->callee->symbol == "append") {
-        expect_args(args, 2);
-        auto container = args[0];
-        auto v = args[1];
-        if (container->type == ValueType::LIST) {
-            static_cast<ListValue *>(container)->value.push_back(v);
-            return nullptr;
-        }
-        if (container->type == ValueType::STRING) {
-            const std::string &str_to_add = as_string(v);
-            static_cast<StringValue *>(container)->value.append(str_to_add);
-            return nullptr;
-        }
-        throw Error(Error::INVALID_ARGUMENT_ERROR,
-                    "Expected list or string type.");
-    }
-    if (s->callee->symbol == "pop") {
-        expect_args(args, 1);
-        auto container = args[0];
-        if (container->type == ValueType::LIST) {
-            static_cast<ListValue *>(container)->value.pop_back();
-            return nullptr;
-        }
-        if (container->type == ValueType::STRING) {
-            static_cast<StringValue *>(container)->value.pop_back();
-            return nullptr;
-        }
-        throw Error(Error::INVALID_ARGUMENT_ERROR,
-                    "Expected list or string type.");
-    }
-    if (s->callee->symbol == "insert") {
-        expect_args(args, 3);
-        auto container = args[0];
-        int idx = (int)as_double(args[1]);
-        auto elem = args[2];
-        if (container->type == ValueType::LIST) {
-            auto &vec = static_cast<ListValue *>(container)->value;
-            vec.insert(vec.begin() + idx, elem);
-            return nullptr;
-        }
-        if (container->type == ValueType::STRING) {
-            const std::string &str_to_add = as_string(elem);
-            auto &str = static_cast<StringValue *>(container)->value;
-            str.insert(idx, str_to_add);
-            return nullptr;
-        }
-        throw Error(Error::INVALID_ARGUMENT_ERROR,
-                    "Expected list or string type.");
-    }
-
-    // GRAPHICS RAYLIB FUNCTIONS
-    if (s->callee->symbol == "init_window") return init_window(memory, args);
-    if (s->callee->symbol == "close_window") return close_window(memory, args);
-    if (s->callee->symbol == "window_should_close")
-        return window_should_close(memory, args);
-    if (s->callee->symbol == "begin_drawing")
-        return begin_drawing(memory, args);
-    if (s->callee->symbol == "end_drawing") return end_drawing(memory, args);
-    if (s->callee->symbol == "clear_background")
-        return clear_background(memory, args);
-    if (s->callee->symbol == "draw_rectangle")
-        return draw_rectangle(memory, args);
-    if (s->callee->symbol == "draw_text") return draw_text(memory, args);
-    if (s->callee->symbol == "draw_circle") return draw_circle(memory, args);
-    if (s->callee->symbol == "is_key_down") return is_key_down(memory, args);
-
-    // check in user-defined functions
-    if (global_scope.runtime.func_exists(s->callee->symbol)) {
-        FunctionDefExpr *function =
-            global_scope.runtime.get_func_value(s->callee->symbol);
-
-        if (function->params.size() != s->params.size()) {
-            throw Error(Error::INVALID_ARGUMENT_ERROR,
-                        fmt::format("Error: Function definition '{}' has {} "
-                                    "parameters but got {} arguments.",
-                                    s->callee->symbol,
-                                    function->params.size(),
-                                    s->params.size()));
-        }
-
-        // give the values to the parameters in a new scope
-        Scope local_scope;
-        local_scope.parent = &global_scope;
-        for (int i = 0; i < function->params.size(); ++i) {
-            LiteralValue *val = evaluate_expr(s->params[i].get(), scope);
-            local_scope.runtime.var_define(function->params[i], val);
-        }
-        LiteralValue *result;
-        // evaluate the function with the given parameters
-        for (const auto &s : function->statements) {
-            result = evaluate(s.get(), &local_scope);
-            if (result) {
-                return result;
+Value Interpreter::run(size_t entry_depth) {
+    const Chunk *chunk = &frames.back().function->chunk;
+    Instruction *ip = frames.back().ip;
+    size_t base = frames.back().base;
+    Instruction *inst;
+
+// after a back-edge or a call, stops with ip saved once the budget is spent.
+// -DCHOCO_NO_BUDGET leaves the check out, see bench_no_budget
+#ifdef CHOCO_NO_BUDGET
+#define SPEND()
+#else
+#define SPEND()                                                                \
+    if (--fuel == 0) [[unlikely]] {                                            \
+        frames.back().ip = ip;                                                 \
+        out_of_budget();                                                       \
+        return Value::none();                                                  \
+    }
+#endif
+
+#if CHOCO_COMPUTED_GOTO
+    static const void *dispatch_table[] = {
+#define CHOCO_OPCODE_LABEL(name) &&op_##name,
+        CHOCO_OPCODES(CHOCO_OPCODE_LABEL)
+#undef CHOCO_OPCODE_LABEL
+    };
+#define CASE(name) op_##name
+#define DISPATCH() goto *dispatch_table[(size_t)(inst = ip++)->op]
+    DISPATCH();
+#else
+#define CASE(name) case OpCode::name
+#define DISPATCH() continue
+    while (true) {
+        inst = ip++;
+        switch (inst->op) {
+#endif
+            CASE(CONSTANT):
+                push(chunk->constants[inst->b]);
+                DISPATCH();
+            CASE(NONE):
+                push(Value::none());
+                DISPATCH();
+            CASE(POP):
+                stack.pop_back();
+                DISPATCH();
+
+            CASE(GET_LOCAL):
+                push(stack[base + inst->b]);
+                DISPATCH();
+            CASE(SET_LOCAL): {
+                Value value = pop();
+                stack[base + inst->b] = value;
+                DISPATCH();
+            }
+            CASE(TEE_LOCAL):
+                stack[base + inst->b] = stack.back();
+                DISPATCH();
+            CASE(SET_LOCAL_ATTR): {
+                Value value = pop();
+                Value &slot = stack[base + inst->b];
+                if (!slot.is_none() && slot.type() != value.type()) {
+                    throw Error(Error::TYPE_ERROR,
+                                "Cannot assign different types");
+                }
+                slot = copy(memory, value);
+                DISPATCH();
+            }
+            CASE(GET_GLOBAL): {
+                Value value = global_values[inst->b];
+                if (value.is_undefined()) {
+                    throw Error(
+                        Error::NAME_ERROR,
+                        fmt::format(
+                            "Variable '{}' is not in scope and does not exist!",
+                            globals.names[inst->b]));
+                }
+                push(value);
+                DISPATCH();
+            }
+            CASE(SET_GLOBAL): {
+                if (global_values[inst->b].is_undefined()) {
+                    throw Error(Error::NAME_ERROR,
+                                fmt::format("Error: Variable name '{}' does "
+                                            "not exist!\n",
+                                            globals.names[inst->b]));
+                }
+                global_values[inst->b] = pop();
+                DISPATCH();
+            }
+            CASE(DEFINE_GLOBAL): {
+                if (!global_values[inst->b].is_undefined()) {
+                    throw Error(Error::NAME_ERROR,
+                                fmt::format("Error: Variable name '{}' already "
+                                            "declared.",
+                                            globals.names[inst->b]));
+                }
+                global_values[inst->b] = pop();
+                DISPATCH();
             }
-        }
-        return nullptr;
-    }
-    return nullptr;
-}
-
-LiteralValue *Interpreter::evaluate_function_definition(FunctionDefExpr *s,
-                                                        Scope *scope) {
-    if (!global_scope.runtime.func_exists(s->name)) {
-        global_scope.runtime.func_define(s->name, s);
-        return nullptr;
-    }
-    throw Error(
-        Error::NAME_ERROR,
-        fmt::format("Error: Function name '{}' already declared.", s->name));
-}
-
-LiteralValue *Interpreter::evaluate_class_definition(ClassDefinitionExpr *s,
-                                                     Scope *scope) {
-    if (!global_scope.runtime.class_exists(s->name)) {
-        global_scope.runtime.class_define(s->name, s);
-        return nullptr;
-    }
-    throw Error(
-        Error::NAME_ERROR,
-        fmt::format("Error: Class name '{}' already declared.", s->name));
-    return nullptr;
-}
-
-LiteralValue *Interpreter::evaluate_object_instantiation(
-    ObjectInstantiationExpr *s,
-    Scope *scope) {
-    // check if class name already exists, if not error
-    if (!global_scope.runtime.class_exists(s->class_name)) {
-        throw Error(Error::NAME_ERROR,
-                    fmt::format("Error: Class name '{}' does not exist.",
-                                s->class_name));
-    }
-
-    ClassDefinitionExpr *class_definition =
-        global_scope.runtime.get_class_value(s->class_name);
-    auto new_obj_value = memory.get<ObjectValue>();
-    // set default values, then call constructor
-    for (auto &attr : class_definition->attributes) {
-        LiteralValue *s = evaluate_expr(attr->value.get(), scope);
-        new_obj_value->values[attr->name] = copy(memory, s);
-    }
-    return new_obj_value;
-}
-
-LiteralValue *Interpreter::evaluate_object_attr_reassign(
-    ObjectAttrReassignExpr *s,
-    Scope *scope) {
-    LiteralValue *eval_dot =
-        evaluate_dot_expr(static_cast<DotExpr *>(s->head.get()), scope);
-    *eval_dot = *evaluate_expr(s->right.get(), scope);
-    return nullptr;
-}
-
-LiteralValue *Interpreter::evaluate_if_statement(IfExpr *s, Scope *scope) {
-    bool run_else = true;
-    auto eval =
-        static_cast<BoolValue *>(evaluate_expr(s->condition.get(), scope));
-    if (eval->value) {
-        run_else = false;
 
-        Scope new_scope;
-        new_scope.parent = scope;
-        for (const auto &s : s->statements) {
-            auto v = evaluate(s.get(), &new_scope);
-            if (v) return v;
-        }
-    } else {
-        for (const auto &elif : s->elif_statements) {
-            eval = static_cast<BoolValue *>(
-                evaluate_expr(elif->condition.get(), scope));
-            if (eval->value) {
-                // new scope for each elif
-                Scope new_scope;
-                new_scope.parent = scope;
+            CASE(GET_ATTR):
+                stack.back() =
+                    attr(stack.back(), chunk->attr_caches[inst->b], *chunk);
+                DISPATCH();
+            CASE(SET_ATTR): {
+                Value value = pop();
+                Value &slot = attr(pop(), chunk->attr_caches[inst->b], *chunk);
+                // an attribute keeps its type once it holds a value
+                if (!slot.is_none() && slot.type() != value.type()) {
+                    throw Error(Error::TYPE_ERROR,
+                                "Cannot assign different types");
+                }
+                slot = copy(memory, value);
+                DISPATCH();
+            }
+            CASE(NEW_OBJECT): {
+                ClassCache &cache = chunk->class_caches[inst->b];
+                if (!cache.value) {
+                    cache.value = find_class(chunk->names[cache.name]);
+                }
+                const Class *class_value = cache.value;
+                push(instantiate(class_value));
+                if (class_value->constructor.chunk.code.empty()) DISPATCH();
+                // the other defaults are evaluated like the body of a
+                // function whose slot 0 is the new instance
+                frames.back().ip = ip;
+                base = stack.size() - 1;
+                push_frame(&class_value->constructor, base);
+                chunk = &class_value->constructor.chunk;
+                ip = chunk->code.data();
+                DISPATCH();
+            }
+            CASE(INIT_ATTR): {
+                Value value = pop();
+                stack[base].as<ObjectValue>()->slots[inst->b] =
+                    copy(memory, value);
+                DISPATCH();
+            }
+            CASE(GET_INDEX): {
+                Value index = pop();
+                stack.back() = get_index(memory, stack.back(), index);
+                DISPATCH();
+            }
+            CASE(SET_INDEX): {
+                Value value = pop();
+                Value index = pop();
+                set_index(memory, pop(), index, value);
+                DISPATCH();
+            }
+            CASE(LIST): {
+                auto list = memory.get<ListValue>();
+                list->value.assign(stack.end() - inst->a, stack.end());
+                stack.resize(stack.size() - inst->a);
+                push(Value::object(list));
+                DISPATCH();
+            }
 
-                run_else = false;
-                for (const auto &s : elif->statements) {
-                    auto v = evaluate(s.get(), &new_scope);
-                    if (v) return v;
+            CASE(ADD):
+            CASE(SUB):
+            CASE(MUL):
+            CASE(DIV):
+            CASE(LT):
+            CASE(GT):
+            CASE(LOT):
+            CASE(GOT):
+            CASE(EQUALS):
+            CASE(NOT_EQUAL): {
+                TokenType op = binary_ops[(int)inst->op - (int)OpCode::ADD];
+                Value right = pop();
+                Value left = stack.back();
+                // a site that keeps seeing the same types skips the ladder
+                // in binary_op from now on
+                if (inst->a == 0) {
+                    if (left.is_number() && right.is_number()) {
+                        inst->op = (OpCode)((int)OpCode::ADD_NUM +
+                                            (int)inst->op - (int)OpCode::ADD);
+                    } else if (inst->op == OpCode::ADD &&
+                               left.type() == ValueType::STRING &&
+                               right.type() == ValueType::STRING) {
+                        inst->op = OpCode::ADD_STR;
+                    }
                 }
-                break;
+                stack.back() = binary_op(memory, op, left, right);
+                DISPATCH();
             }
-        }
-        if (run_else) {
-            Scope new_scope;
-            new_scope.parent = scope;
-            for (const auto &s : s->else_statements) {
-                auto v = evaluate(s.get(), &new_scope);
-                if (v) return v;
+            // the guard failed, run it generically and stay generic
+#define DEQUICKEN()                                                            \
+    inst->op = generic_op(inst->op);                                           \
+    inst->a = 1;                                                               \
+    ip = inst;                                                                 \
+    DISPATCH()
+#define NUMBER_OP(name, token)                                                 \
+    CASE(name##_NUM) : {                                                       \
+        Value right = stack.back();                                            \
+        Value left = stack[stack.size() - 2];                                  \
+        if (left.is_int() && right.is_int()) [[likely]] {                      \
+            stack.pop_back();                                                  \
+            int_op(TokenType::token, left.as_int(), right.as_int(),            \
+                   stack.back());                                              \
+            DISPATCH();                                                        \
+        }                                                                      \
+        if (!left.is_number() || !right.is_number()) {                         \
+            DEQUICKEN();                                                       \
+        }                                                                      \
+        stack.pop_back();                                                      \
+        number_op(TokenType::token, left.as_number(), right.as_number(),       \
+                  stack.back());                                               \
+        DISPATCH();                                                            \
+    }
+            NUMBER_OP(ADD, PLUS)
+            NUMBER_OP(SUB, MINUS)
+            NUMBER_OP(MUL, MUL)
+            NUMBER_OP(DIV, DIV)
+            NUMBER_OP(LT, LT)
+            NUMBER_OP(GT, GT)
+            NUMBER_OP(LOT, LOT)
+            NUMBER_OP(GOT, GOT)
+            NUMBER_OP(EQUALS, EQUALS)
+            NUMBER_OP(NOT_EQUAL, NOT_EQUAL)
+#undef NUMBER_OP
+            CASE(ADD_STR): {
+                Value right = stack.back();
+                Value left = stack[stack.size() - 2];
+                if (left.type() != ValueType::STRING ||
+                    right.type() != ValueType::STRING) {
+                    DEQUICKEN();
+                }
+                stack.pop_back();
+                stack.back() = Value::object(
+                    memory.get<StringValue>(left.as<StringValue>()->value +
+                                            right.as<StringValue>()->value));
+                DISPATCH();
+            }
+#undef DEQUICKEN
+            CASE(NUM_LOCAL):
+                numeric_op(binary_ops[inst->a],
+                           stack.back(),
+                           stack[base + inst->b],
+                           stack.back());
+                DISPATCH();
+            CASE(NUM_CONST):
+                numeric_op(binary_ops[inst->a],
+                           stack.back(),
+                           chunk->constants[inst->b],
+                           stack.back());
+                DISPATCH();
+            CASE(CHECK_TYPE): {
+                Annotation type = (Annotation)inst->a;
+                if (!fits(type, stack.back())) {
+                    throw Error(Error::TYPE_ERROR,
+                                fmt::format("Error: '{}' can only hold a {}.",
+                                            chunk->names[inst->b],
+                                            annotation_name(type)));
+                }
+                DISPATCH();
+            }
+            CASE(ADD_IN_PLACE): {
+                Value right = pop();
+                Value &left = stack.back();
+                if (left.is_number() && right.is_number()) {
+                    numeric_op(TokenType::PLUS, left, right, left);
+                    DISPATCH();
+                }
+                left = add_in_place(memory, left, right);
+                DISPATCH();
+            }
+            CASE(CONCAT): {
+                Value right = pop();
+                stack.back() = concat(memory, stack.back(), right, inst->b);
+                DISPATCH();
+            }
+            CASE(NEGATE): {
+                Value value = stack.back();
+                if (!value.is_number()) {
+                    throw Error(Error::TYPE_ERROR,
+                                "Error: Invalid operation 'Minus'.");
+                }
+                stack.back() = value.is_int()
+                                   ? Value::integer(-(int64_t)value.as_int())
+                                   : Value::number(-value.as_number());
+                DISPATCH();
+            }
+            CASE(NOT): {
+                Value value = stack.back();
+                if (!value.is_bool()) {
+                    throw Error(Error::TYPE_ERROR,
+                                "Error: Invalid operation 'Not'.");
+                }
+                stack.back() = Value::boolean(!value.as_bool());
+                DISPATCH();
             }
-        }
-    }
-    return nullptr;
-}
 
-LiteralValue *Interpreter::evaluate_while_statement(WhileExpr *s,
-                                                    Scope *scope) {
-    auto eval =
-        static_cast<BoolValue *>(evaluate_expr(s->condition.get(), scope));
-    while (eval->value) {
-        Scope new_scope;
-        new_scope.parent = scope;
-        // TODO: break/continue
-        for (const auto &s : s->statements) {
-            auto v = evaluate(s.get(), &new_scope);
-            if (v) return v;
+            CASE(JUMP):
+                ip = chunk->code.data() + inst->b;
+                DISPATCH();
+            CASE(LOOP):
+                ip = chunk->code.data() + inst->b;
+                SPEND();
+                DISPATCH();
+            CASE(JUMP_IF_FALSE):
+            CASE(JUMP_IF_TRUE): {
+                Value condition = pop();
+                if (!condition.is_bool()) {
+                    throw Error(Error::TYPE_ERROR,
+                                "Error: Condition must be a boolean.");
+                }
+                if (condition.as_bool() == (inst->op == OpCode::JUMP_IF_TRUE)) {
+                    ip = chunk->code.data() + inst->b;
+                }
+                DISPATCH();
+            }
+#define COMPARE_AND_BRANCH(name, op)                                           \
+    CASE(JUMP_##name) : {                                                      \
+        Value right = stack.back();                                            \
+        Value left = stack[stack.size() - 2];                                  \
+        stack.resize(stack.size() - 2);                                        \
+        bool result;                                                           \
+        if (left.is_int() && right.is_int()) {                                 \
+            result = left.as_int() op right.as_int();                          \
+        } else if (left.is_number() && right.is_number()) {                    \
+            result = left.as_number() op right.as_number();                    \
+        } else {                                                               \
+            result = binary_op(memory, TokenType::name, left, right)           \
+                         .as_bool();                                           \
+        }                                                                      \
+        if (result == (bool)inst->a) {                                         \
+            ip = chunk->code.data() + inst->b;                                 \
+        }                                                                      \
+        DISPATCH();                                                            \
+    }
+            COMPARE_AND_BRANCH(LT, <)
+            COMPARE_AND_BRANCH(GT, >)
+            COMPARE_AND_BRANCH(LOT, <=)
+            COMPARE_AND_BRANCH(GOT, >=)
+            COMPARE_AND_BRANCH(EQUALS, ==)
+            COMPARE_AND_BRANCH(NOT_EQUAL, !=)
+#undef COMPARE_AND_BRANCH
+
+            CASE(CALL): {
+                Function *function = function_at(inst->b);
+                size_t args = stack.size() - inst->a;
+                if (!function->param_types.empty()) {
+                    check_params(*function, args);
+                }
+                if (function->native) {
+                    // the machine code was typed for number parameters
+                    bool numbers = std::all_of(stack.begin() + args,
+                                               stack.end(),
+                                               [](Value v) {
+                                                   return v.is_number();
+                                               });
+                    if (numbers) {
+                        // the machine code only knows doubles
+                        for (size_t i = args; i < stack.size(); ++i) {
+                            stack[i] = Value::number(stack[i].as_number());
+                        }
+                        stack.resize(args + function->slots);
+                        Value result = function->native(stack.data() + args);
+                        stack.resize(args);
+                        push(result);
+                        DISPATCH();
+                    }
+                } else if (options.jit &&
+                           function->calls++ == options.jit_threshold) {
+                    function->native = jit.compile(*function);
+                }
+                frames.back().ip = ip;
+                // the arguments on top of the stack become the first slots
+                // of the frame, the Resolver already checked their count
+                base = args;
+                push_frame(function, base);
+                chunk = &function->chunk;
+                ip = chunk->code.data();
+                SPEND();
+                DISPATCH();
+            }
+            CASE(TAIL_CALL): {
+                Function *function = function_at(inst->b);
+                if (!function->param_types.empty()) {
+                    check_params(*function, stack.size() - inst->a);
+                }
+                // the arguments take over the caller's slots, the frame
+                // still returns to where the caller would have
+                std::copy(stack.end() - inst->a, stack.end(),
+                          stack.begin() + base);
+                stack.resize(base + inst->a);
+                stack.resize(base + function->slots);
+                frames.back().function = function;
+                chunk = &function->chunk;
+                ip = chunk->code.data();
+                SPEND();
+                DISPATCH();
+            }
+            CASE(CALL_NATIVE): {
+                size_t first = stack.size() - inst->a;
+                std::span<const Value> args(stack.data() + first, inst->a);
+                Value result = natives[inst->b].fn(memory, args);
+                stack.resize(first);
+                push(result);
+                DISPATCH();
+            }
+            CASE(CALL_METHOD): {
+                size_t args = stack.size() - inst->a - 1;
+                MethodCache &cache = chunk->method_caches[inst->b];
+                const Function *function =
+                    method(stack[args], cache, *chunk, inst->a);
+                if (!function->param_types.empty()) {
+                    check_params(*function, args);
+                }
+                // the instance is the first slot of the frame, self
+                frames.back().ip = ip;
+                base = args;
+                push_frame(function, base);
+                chunk = &function->chunk;
+                ip = chunk->code.data();
+                SPEND();
+                DISPATCH();
+            }
+            CASE(DEFINE_FUNCTION): {
+                Function *function =
+                    programs.back()->functions[inst->b].get();
+                function_values[function->slot] = function;
+                DISPATCH();
+            }
+            CASE(DEFINE_CLASS): {
+                Class *class_value = programs.back()->classes[inst->b].get();
+                if (global_scope.runtime.class_exists(class_value->name)) {
+                    throw Error(
+                        Error::NAME_ERROR,
+                        fmt::format("Error: Class name '{}' already declared.",
+                                    class_value->name));
+                }
+                global_scope.runtime.class_define(class_value->name,
+                                                  class_value);
+                DISPATCH();
+            }
+            CASE(RETURN): {
+                Value result = stack.back();
+                stack.resize(base);
+                frames.pop_back();
+                if (frames.size() == entry_depth) return result;
+                push(result);
+                const CallFrame &caller = frames.back();
+                chunk = &caller.function->chunk;
+                ip = caller.ip;
+                base = caller.base;
+                DISPATCH();
+            }
+#if !CHOCO_COMPUTED_GOTO
         }
-        // recalculate eval
-        eval =
-            static_cast<BoolValue *>(evaluate_expr(s->condition.get(), scope));
     }
-    return nullptr;
+#endif
+#undef CASE
+#undef DISPATCH
+#undef SPEND
 }
 
-LiteralValue *Interpreter::evaluate_return_statement(ReturnExpr *s,
-                                                     Scope *scope) {
-    return evaluate_expr(s->content.get(), scope);
+void Interpreter::recursion_error(const Function *function) {
+    throw Error(Error::RECURSION_ERROR,
+                fmt::format("Error: Maximum recursion depth of {} "
+                            "exceeded in '{}'.",
+                            options.max_frames,
+                            function->name));
 }
 
-LiteralValue *Interpreter::evaluate_list(ListExpr *s, Scope *scope) {
-    auto list = memory.get<ListValue>();
-    for (auto &element : s->elements) {
-        auto eval = evaluate_expr(element.get(), scope);
-        list->value.push_back(eval);
-    }
-    return list;
+void Interpreter::missing_function(uint32_t slot) {
+    throw Error(Error::NAME_ERROR,
+                fmt::format("Error: Function '{}' does not exist.",
+                            functions.names[slot]));
 }
 
-LiteralValue *Interpreter::evaluate_expr(Expr *expr, Scope *scope) {
-    if (expr->type == ASTNodeType::LITERAL) {
-        return static_cast<LiteralExpr *>(expr)->value.get();
-    }
-    if (expr->type == ASTNodeType::LIST) {
-        return evaluate_list(static_cast<ListExpr *>(expr), scope);
-    }
-    if (expr->type == ASTNodeType::SYMBOL) {
-        // check scopes
-        const std::string &name = (static_cast<SymbolExpr *>(expr))->symbol;
-        return get_variable(name, scope);
-    }
-    if (expr->type == ASTNodeType::DOT_SYMBOL) {
-        // check scopes
-        auto dot = static_cast<DotExpr *>(expr);
-        return evaluate_dot_expr(dot, scope);
-    }
-    if (expr->type == ASTNodeType::BINARY) {
-        return evaluate_binary_expr(static_cast<BinaryExpr *>(expr), scope);
-    }
-    if (expr->type == ASTNodeType::UNARY) {
-        return evaluate_unary_expr(static_cast<UnaryExpr *>(expr), scope);
-    }
-    if (expr->type == ASTNodeType::FUNCTION_CALL) {
-        return evaluate_function_call(static_cast<CallExpr *>(expr), scope);
-    }
-    if (expr->type == ASTNodeType::OBJECT_INSTANTIATION) {
-        return evaluate_object_instantiation(
-            static_cast<ObjectInstantiationExpr *>(expr), scope);
-    }
-    return nullptr;
-}
-
-LiteralValue *Interpreter::evaluate_binary_expr(BinaryExpr *v, Scope *scope) {
-    auto left = evaluate_expr(v->left.get(), scope);
-    auto right = evaluate_expr(v->right.get(), scope);
-    if (left->type == ValueType::NUMBER && right->type == ValueType::NUMBER) {
-        auto lval = static_cast<NumValue *>(left);
-        auto rval = static_cast<NumValue *>(right);
-        NumValue *res_num = memory.get<NumValue>(0.0);
-        BoolValue *res_bool = memory.get<BoolValue>(0.0);
-        // arithmetic operators
-        if (v->op == TokenType::PLUS) {
-            res_num->value = lval->value + rval->value;
-            return res_num;
-        } else if (v->op == TokenType::MINUS) {
-            res_num->value = lval->value - rval->value;
-            return res_num;
-        } else if (v->op == TokenType::MUL) {
-            res_num->value = lval->value * rval->value;
-            return res_num;
-        } else if (v->op == TokenType::DIV) {
-            if (rval->value != 0.0)
-                res_num->value = lval->value / rval->value;
-            else
-                res_num->value = 0.0;
-            return res_num;
-        }
-        // boolean operators
-        else if (v->op == TokenType::LT) {
-            res_bool->value = lval->value < rval->value;
-        } else if (v->op == TokenType::GT) {
-            res_bool->value = lval->value > rval->value;
-        } else if (v->op == TokenType::LOT) {
-            res_bool->value = lval->value <= rval->value;
-        } else if (v->op == TokenType::GOT) {
-            res_bool->value = lval->value >= rval->value;
-        } else if (v->op == TokenType::EQUALS) {
-            res_bool->value = lval->value == rval->value;
-        } else if (v->op == TokenType::NOT_EQUAL) {
-            res_bool->value = lval->value != rval->value;
-        } else {
-            throw Error(
-                Error::TYPE_ERROR,
-                fmt::format("Error: Invalid numerical operation '{}'.", v->op));
-        }
-        return res_bool;
-    }
-
-    if (left->type == ValueType::STRING && right->type == ValueType::STRING) {
-        auto lval = static_cast<StringValue *>(left);
-        auto rval = static_cast<StringValue *>(right);
-        StringValue *res = nullptr;
-        if (v->op == TokenType::PLUS) {
-            res = memory.get<StringValue>(lval->value + rval->value);
-            return res;
-        }
-        if (v->op == TokenType::EQUALS) {
-            return memory.get<BoolValue>(lval->value == rval->value);
-        }
-        throw Error(
-            Error::TYPE_ERROR,
-            fmt::format("Error: Invalid string operation '{}'.", v->op));
-    }
-    // string concatenation
-    if (left->type == ValueType::STRING && right->type == ValueType::NUMBER) {
-        auto lval = static_cast<StringValue *>(left);
-        auto rval = static_cast<NumValue *>(right);
-        StringValue *res = nullptr;
-        if (v->op == TokenType::PLUS) {
-            // remove unnecessary digits in string by rounding
-            std::string num = std::to_string(rval->value);
-            if (std::round(rval->value) == rval->value) {
-                num = std::to_string((int)rval->value);
-            }
-            res = memory.get<StringValue>(lval->value + num);
-            return res;
-        }
-        throw Error(
-            Error::TYPE_ERROR,
-            fmt::format("Error: Invalid string-number operation '{}'.", v->op));
-    }
-    if (left->type == ValueType::NUMBER && right->type == ValueType::STRING) {
-        auto lval = static_cast<NumValue *>(left);
-        auto rval = static_cast<StringValue *>(right);
-        StringValue *res = nullptr;
-        if (v->op == TokenType::PLUS) {
-            // remove unnecessary digits in string by rounding
-            std::string num = std::to_string(lval->value);
-            if (std::round(lval->value) == lval->value) {
-                num = std::to_string((int)lval->value);
-            }
-            res = memory.get<StringValue>(num + rval->value);
-            return res;
+void Interpreter::check_params(const Function &function, size_t args) {
+    // the same error an inlined copy raises from its CHECK_TYPE
+    for (size_t i = 0; i < function.param_types.size(); ++i) {
+        Annotation type = function.param_types[i];
+        if (!fits(type, stack[args + i])) {
+            throw Error(Error::TYPE_ERROR,
+                        fmt::format("Error: '{}' can only hold a {}.",
+                                    function.params[i],
+                                    annotation_name(type)));
         }
-        throw Error(
-            Error::TYPE_ERROR,
-            fmt::format("Error: Invalid number-string operation '{}'.", v->op));
     }
+}
 
-    if (left->type == ValueType::STRING && right->type == ValueType::BOOL) {
-        auto lval = static_cast<StringValue *>(left);
-        auto rval = static_cast<BoolValue *>(right);
-        StringValue *res = nullptr;
-        if (v->op == TokenType::PLUS) {
-            res = memory.get<StringValue>(lval->value +
-                                          (rval->value ? "true" : "false"));
-            return res;
-        }
-        throw Error(
-            Error::TYPE_ERROR,
-            fmt::format("Error: Invalid string-bool operation '{}'.", v->op));
-    }
-    if (left->type == ValueType::BOOL && right->type == ValueType::STRING) {
-        auto lval = static_cast<BoolValue *>(left);
-        auto rval = static_cast<StringValue *>(right);
-        StringValue *res = nullptr;
-        if (v->op == TokenType::PLUS) {
-            res = memory.get<StringValue>((lval->value ? "true" : "false") +
-                                          rval->value);
-            return res;
-        }
+Class *Interpreter::find_class(const std::string &class_name) {
+    // check if class name already exists, if not error
+    if (!global_scope.runtime.class_exists(class_name)) {
         throw Error(
-            Error::TYPE_ERROR,
-            fmt::format("Error: Invalid bool-string operation '{}'.", v->op));
-    }
-
-    // comparison/boolean operators
-    if (left->type == ValueType::BOOL && right->type == ValueType::BOOL) {
-        auto lval = static_cast<BoolValue *>(left)->value;
-        auto rval = static_cast<BoolValue *>(right)->value;
-        BoolValue *res = memory.get<BoolValue>(false);
-        if (v->op == TokenType::AND) {
-            res->value = lval && rval;
-        } else if (v->op == TokenType::OR) {
-            res->value = lval || rval;
-        } else if (v->op == TokenType::EQUALS) {
-            res->value = lval == rval;
-        } else if (v->op == TokenType::NOT_EQUAL) {
-            res->value = lval != rval;
-        }
-        return res;
+            Error::NAME_ERROR,
+            fmt::format("Error: Class name '{}' does not exist.", class_name));
     }
-    throw Error(Error::TYPE_ERROR,
-                fmt::format("Error: Invalid operation '{}'.", v->op));
+    return global_scope.runtime.get_class_value(class_name);
 }
 
-LiteralValue *Interpreter::evaluate_unary_expr(UnaryExpr *v, Scope *scope) {
-    auto left = evaluate_expr(v->unary.get(), scope);
-    // -<expr>
-    if (left->type == ValueType::NUMBER && v->op == TokenType::MINUS) {
-        // INFO: don't alter NumValue-> value directly because it might change
-        // some variable's value, need a copy
-        NumValue *res =
-            memory.get<NumValue>(-static_cast<NumValue *>(left)->value);
-        return res;
-    }
-    // !<bool-expr>
-    else if (left->type == ValueType::BOOL && v->op == TokenType::NOT) {
-        BoolValue *res =
-            memory.get<BoolValue>(!static_cast<BoolValue *>(left)->value);
-        return res;
+Value Interpreter::instantiate(const Class *class_value) {
+    auto obj = memory.get<ObjectValue>(&class_value->shape,
+                                       class_value->prototype);
+    // every instance gets strings of its own
+    for (Value &slot : obj->slots) {
+        if (slot.is_object()) slot = copy(memory, slot);
     }
-    return nullptr;
+    return Value::object(obj);
 }
 
-LiteralValue *Interpreter::evaluate_dot_expr(DotExpr *s, Scope *scope) {
-    // get head value
-    LiteralValue *head = evaluate_expr(s->head.get(), scope);
-    // Object Value to access attributes
-    ObjectValue *obj = static_cast<ObjectValue *>(head);
-    // Literal Value pointer to track what to return
-    LiteralValue *to_return = head;
-
-    for (auto &after : s->after) {
-        if (after->type == ASTNodeType::SYMBOL) {
-            // WARN: function calls not implemented here
-            SymbolExpr *symbol = static_cast<SymbolExpr *>(after.get());
-            if (obj->values[symbol->symbol]) {
-                to_return = obj->values[symbol->symbol];
-                if (to_return->type == ValueType::OBJECT) {
-                    obj = static_cast<ObjectValue *>(to_return);
-                }
-            } else {
-                throw Error(Error::NAME_ERROR,
-                            "Failed to find symbol after dot expression.");
-            }
-        } else {
-            throw Error(Error::SYNTAX_ERROR,
-                        "Invalid function call dot expression.");
-        }
+Value &Interpreter::attr_miss(Value head, AttrCache &cache,
+                              const Chunk &chunk) {
+    const std::string &name = chunk.names[cache.name];
+    if (head.type() != ValueType::OBJECT) {
+        throw Error(Error::TYPE_ERROR,
+                    fmt::format("Error: Cannot access '{}' of a non-object.",
+                                name));
     }
-
-    return to_return;
-}
-
-LiteralValue *Interpreter::get_variable(const std::string &s, Scope *scope) {
-    while (scope != nullptr) {
-        if (scope->runtime.var_exists(s)) {
-            // returning a reference essentially
-            LiteralValue *v = scope->runtime.get_variable_value(s);
-            return v;
-        } // move up the tree
-        scope = scope->parent;
+    ObjectValue *obj = head.as<ObjectValue>();
+    int64_t slot = obj->shape->find(name);
+    if (slot < 0) {
+        throw Error(Error::NAME_ERROR,
+                    "Failed to find symbol after dot expression.");
     }
-    throw Error(
-        Error::NAME_ERROR,
-        fmt::format("Variable '{}' is not in scope and does not exist!", s));
+    // the site now expects this shape
+    cache.shape = obj->shape;
+    cache.slot = slot;
+    return obj->slots[slot];
 }
 
-LiteralValue *Interpreter::print(CallExpr *s, Scope *scope) {
-    if (s->params.size() == 0) {
-        fmt::println("");
-    } else {
-        auto *child = s->params.front().get();
-        LiteralValue *v = evaluate_expr(child, scope);
-        if (v) {
-            fmt::println("{}", *v);
-        } else
-            throw Error(Error::ARGUMENT_ERROR, "Error: Invalid value!");
+const Function *Interpreter::method_miss(Value receiver, MethodCache &cache,
+                                         const Chunk &chunk, size_t argc) {
+    const std::string &name = chunk.names[cache.name];
+    if (receiver.type() != ValueType::OBJECT) {
+        throw Error(Error::TYPE_ERROR,
+                    fmt::format("Error: Cannot call '{}' of a non-object.",
+                                name));
     }
-    return nullptr;
-}
-
-LiteralValue *Interpreter::input(CallExpr *s, Scope *scope) {
-    // print the prompt
-    print(s, scope);
-    // get the different values
-    std::string in;
-    std::cin >> in;
-    return memory.get<StringValue>(in);
+    const Shape *shape = receiver.as<ObjectValue>()->shape;
+    auto it = shape->methods.find(name);
+    if (it == shape->methods.end()) {
+        throw Error(
+            Error::NAME_ERROR,
+            fmt::format("Error: Function '{}' does not exist.", name));
+    }
+    // the Resolver can't know the box, so the arguments are counted here
+    // once per shape
+    const Function *function = function_at(it->second);
+    if (function->params.size() != argc + 1) {
+        throw Error(Error::INVALID_ARGUMENT_ERROR,
+                    fmt::format("Error: Function definition '{}' has {} "
+                                "parameters but got {} arguments.",
+                                function->name,
+                                function->params.size() - 1,
+                                argc));
+    }
+    cache.shape = shape;
+    cache.function = function;
+    return function;
 }
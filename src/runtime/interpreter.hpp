@@ -1,8 +1,15 @@
 #ifndef RUNTIME_INTERPETER_HPP
 #define RUNTIME_INTERPETER_HPP
 
+#include <vector>
+
 #include "ast.hpp"
+#include "compiler/bytecode.hpp"
+#include "compiler/inliner.hpp"
+#include "compiler/resolver.hpp"
+#include "runtime/jit.hpp"
 #include "runtime/memory.hpp"
+#include "runtime/natives.hpp"
 #include "runtime/runtime.hpp"
 #include "runtime/scope.hpp"
 #include "runtime/value.hpp"
@@ -10,48 +17,135 @@
 #include "util/error.hpp"
 #include "util/util.hpp"
 
+struct InterpreterOptions {
+    // print the AST before and after Optimizer::optimize()
+    bool dump_ast = false;
+    // deepest the choco call stack may get before a RECURSION_ERROR, calls
+    // run on the heap so this is not limited by the native stack
+    size_t max_frames = 1 << 16;
+    // compile hot confections to machine code where the Jit supports it
+    bool jit = true;
+    // calls a confection makes in the interpreter before it is compiled
+    uint32_t jit_threshold = 100;
+    // which small confections get copied into their callers
+    InlineOptions inlining{};
+    // loop iterations and calls one eval() or resume() may run before it
+    // stops, 0 for no limit. compiled confections can't count theirs so the
+    // Jit is off while there is one
+    uint64_t budget = 0;
+    // stop with a TIMEOUT_ERROR once the budget is spent, or pause so the
+    // host can resume() the program later
+    bool yield = false;
+};
+
+// compiles the AST to bytecode and runs it on a stack machine
 class Interpreter {
   public:
-    Interpreter();
-    void eval(const std::vector<uptr<Statement>> &ast);
-
-    // open for testing
-    LiteralValue *evaluate(Statement *statement, Scope *scope);
+    Interpreter(InterpreterOptions options = {});
+    // a program still paused is dropped
+    void eval(std::vector<uptr<Statement>> &ast);
+    // whether the last eval() or resume() ran out of budget with yield set
+    bool paused() const {
+        return suspended;
+    }
+    // runs a paused program on from where it stopped with a fresh budget
+    void resume();
 
   private:
-    // statements
-    LiteralValue *evaluate_variable_declaration(VariableDeclaration *v,
-                                                Scope *scope);
-
-    LiteralValue *evaluate_function_call(CallExpr *s, Scope *scope);
-    LiteralValue *evaluate_function_definition(FunctionDefExpr *s,
-                                               Scope *scope);
-    LiteralValue *evaluate_class_definition(ClassDefinitionExpr *s,
-                                            Scope *scope);
-    LiteralValue *evaluate_object_instantiation(ObjectInstantiationExpr *s,
-                                                Scope *scope);
-    LiteralValue *evaluate_object_attr_reassign(ObjectAttrReassignExpr *s,
-                                                Scope *scope);
-
-    LiteralValue *evaluate_if_statement(IfExpr *s, Scope *scope);
-    LiteralValue *evaluate_while_statement(WhileExpr *s, Scope *scope);
-    LiteralValue *evaluate_return_statement(ReturnExpr *s, Scope *scope);
-    LiteralValue *evaluate_list(ListExpr *s, Scope *scope);
-
-    // expressions
-    LiteralValue *evaluate_expr(Expr *expr, Scope *scope);
-    LiteralValue *evaluate_binary_expr(BinaryExpr *v, Scope *scope);
-    LiteralValue *evaluate_unary_expr(UnaryExpr *v, Scope *scope);
-
-    LiteralValue *evaluate_dot_expr(DotExpr *s, Scope *scope);
-    LiteralValue *get_variable(const std::string &s, Scope *scope);
-
-    // INFO: predefined STDIO functions
-    LiteralValue *print(CallExpr *s, Scope *scope);
-    LiteralValue *input(CallExpr *s, Scope *scope);
+    // dispatch loop from the ip of the top frame, returns the value gifted
+    // once the frames are back down to entry_depth. calls run inside the
+    // same loop
+    Value run(size_t entry_depth);
+    void refuel() {
+        fuel = options.budget ? options.budget : UINT64_MAX;
+    }
+    // TIMEOUT_ERROR unless the program may pause
+    void out_of_budget();
+
+    // the frame's arguments are already on the stack from base
+    void push_frame(const Function *function, size_t base) {
+        if (frames.size() == options.max_frames) recursion_error(function);
+        stack.resize(base + function->slots);
+        frames.push_back({function, nullptr, base});
+    }
+    [[noreturn]] void recursion_error(const Function *function);
+    Function *function_at(uint32_t slot) {
+        Function *function = function_values[slot];
+        if (!function) missing_function(slot);
+        return function;
+    }
+    [[noreturn]] void missing_function(uint32_t slot);
+    // TYPE_ERROR unless the arguments from stack[args] fit the annotations
+    // of function's parameters
+    void check_params(const Function &function, size_t args);
+    Class *find_class(const std::string &class_name);
+    // a copy of the prototype of class_value, its constructor still has to
+    // run on it
+    Value instantiate(const Class *class_value);
 
+    // the slot of an attribute, through the inline cache of its site
+    Value &attr(Value head, AttrCache &cache, const Chunk &chunk) {
+        if (head.is_object() && head.as_object()->type == ValueType::OBJECT) {
+            ObjectValue *obj = head.as<ObjectValue>();
+            if (obj->shape == cache.shape) return obj->slots[cache.slot];
+        }
+        return attr_miss(head, cache, chunk);
+    }
+    Value &attr_miss(Value head, AttrCache &cache, const Chunk &chunk);
+    // the method receiver has under the name of cache, through the cache
+    const Function *method(Value receiver, MethodCache &cache,
+                           const Chunk &chunk, size_t argc) {
+        if (receiver.is_object() &&
+            receiver.as_object()->type == ValueType::OBJECT &&
+            receiver.as<ObjectValue>()->shape == cache.shape) {
+            return cache.function;
+        }
+        return method_miss(receiver, cache, chunk, argc);
+    }
+    const Function *method_miss(Value receiver, MethodCache &cache,
+                                const Chunk &chunk, size_t argc);
+
+    void push(Value value) {
+        stack.push_back(value);
+    }
+    Value pop() {
+        Value value = stack.back();
+        stack.pop_back();
+        return value;
+    }
+
+    // the class table, functions and variables live in slot tables
+    InterpreterOptions options;
     Scope global_scope;
+    GlobalTable globals;
+    // Value::undefined() until the DEFINE_GLOBAL runs
+    std::vector<Value> global_values;
+    FunctionTable functions;
+    // nullptr until the DEFINE_FUNCTION runs
+    std::vector<Function *> function_values;
+    NativeRegistry natives;
     Memory memory;
+    Jit jit;
+
+    // initial capacities, not limits
+    static constexpr size_t STACK_SIZE = 1 << 16;
+    static constexpr size_t FRAMES_RESERVED = 1024;
+
+    struct CallFrame {
+        const Function *function;
+        // where to resume once the frame it called returns
+        Instruction *ip;
+        // index of the frame's first slot in the stack
+        size_t base;
+    };
+
+    std::vector<Value> stack;
+    std::vector<CallFrame> frames;
+    // what is left of the budget, every LOOP and call spends one
+    uint64_t fuel = UINT64_MAX;
+    bool suspended = false;
+    // functions stay defined across eval() calls
+    std::vector<uptr<Program>> programs;
 };
 
 #endif // RUNTIME_INTERPETER_HPP
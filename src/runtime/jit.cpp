@@ -0,0 +1,661 @@
+#include "jit.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if CHOCO_JIT
+#include <sys/mman.h>
+#endif
+
+Jit::~Jit() {
+#if CHOCO_JIT
+    for (const Region &region : regions) {
+        munmap(region.memory, region.size);
+    }
+#endif
+}
+
+#if !CHOCO_JIT
+
+JitFn Jit::compile(const Function &function) {
+    return nullptr;
+}
+
+#else
+
+namespace {
+
+// what a stack entry or slot holds at some instruction, every path that
+// reaches the instruction has to agree
+enum class Type : uint8_t { UNSET, NUMBER, BOOL, NONE, CONFLICT };
+
+struct State {
+    bool reached = false;
+    std::vector<Type> stack;
+    std::vector<Type> slots;
+};
+
+// the operator to compile inst as, the JIT only ever sees numbers where
+// quickened and in place adds are all plain arithmetic
+OpCode base_op(OpCode op) {
+    op = generic_op(op);
+    return op == OpCode::ADD_IN_PLACE ? OpCode::ADD : op;
+}
+
+// splits NUM_LOCAL and NUM_CONST back into a load and the operator, which
+// the JIT already knows how to type and compile
+std::vector<Instruction> unfuse(const std::vector<Instruction> &code) {
+    std::vector<Instruction> result;
+    result.reserve(code.size());
+    std::vector<uint32_t> moved(code.size() + 1);
+    for (size_t i = 0; i < code.size(); ++i) {
+        moved[i] = result.size();
+        Instruction inst = code[i];
+        if (inst.op == OpCode::NUM_LOCAL || inst.op == OpCode::NUM_CONST) {
+            OpCode load = inst.op == OpCode::NUM_LOCAL ? OpCode::GET_LOCAL
+                                                       : OpCode::CONSTANT;
+            result.push_back({load, 0, inst.b});
+            result.push_back({(OpCode)((int)OpCode::ADD + inst.a)});
+            continue;
+        }
+        result.push_back(inst);
+    }
+    moved[code.size()] = result.size();
+    for (Instruction &inst : result) {
+        if (is_jump(inst.op)) inst.b = moved[inst.b];
+    }
+    return result;
+}
+
+bool is_fused_compare(OpCode op) {
+    return op >= OpCode::JUMP_LT && op <= OpCode::JUMP_NOT_EQUAL;
+}
+
+// the compare behind a fused compare-and-branch
+OpCode compare_of(OpCode op) {
+    if (is_fused_compare(op)) {
+        return (OpCode)((int)OpCode::LT + (int)op - (int)OpCode::JUMP_LT);
+    }
+    return op;
+}
+
+// the type of left op right, CONFLICT if the VM would raise a TYPE_ERROR
+Type compare_type(OpCode op, Type left, Type right) {
+    if (left == Type::NUMBER && right == Type::NUMBER) return Type::BOOL;
+    bool equality = op == OpCode::EQUALS || op == OpCode::NOT_EQUAL;
+    if (equality && left == Type::BOOL && right == Type::BOOL) {
+        return Type::BOOL;
+    }
+    return Type::CONFLICT;
+}
+
+// false if the paths disagree on the stack
+bool merge(State &into, const State &from, bool &changed) {
+    if (!into.reached) {
+        into = from;
+        changed = true;
+        return true;
+    }
+    if (into.stack != from.stack) return false;
+    for (size_t i = 0; i < into.slots.size(); ++i) {
+        if (into.slots[i] != from.slots[i] &&
+            into.slots[i] != Type::CONFLICT) {
+            into.slots[i] = Type::CONFLICT;
+            changed = true;
+        }
+    }
+    return true;
+}
+
+// types every reachable instruction, false if one can't be typed
+bool analyze(const Function &function, std::vector<State> &states,
+             size_t &max_depth) {
+    const Chunk &chunk = function.chunk;
+    states.assign(chunk.code.size(), State{});
+    State entry;
+    entry.reached = true;
+    entry.slots.assign(function.slots, Type::UNSET);
+    for (size_t i = 0; i < function.params.size(); ++i) {
+        entry.slots[i] = Type::NUMBER;
+    }
+    bool changed = false;
+    merge(states[0], entry, changed);
+    std::vector<size_t> worklist{0};
+    max_depth = 0;
+
+    while (!worklist.empty()) {
+        size_t at = worklist.back();
+        worklist.pop_back();
+        const Instruction &inst = chunk.code[at];
+        OpCode op = base_op(inst.op);
+        State state = states[at];
+        auto &stack = state.stack;
+        size_t popped = 0;
+        switch (op) {
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV:
+            case OpCode::LT:
+            case OpCode::GT:
+            case OpCode::LOT:
+            case OpCode::GOT:
+            case OpCode::EQUALS:
+            case OpCode::NOT_EQUAL:
+            case OpCode::JUMP_LT:
+            case OpCode::JUMP_GT:
+            case OpCode::JUMP_LOT:
+            case OpCode::JUMP_GOT:
+            case OpCode::JUMP_EQUALS:
+            case OpCode::JUMP_NOT_EQUAL:
+                popped = 2;
+                break;
+            case OpCode::POP:
+            case OpCode::SET_LOCAL:
+            case OpCode::SET_LOCAL_ATTR:
+            case OpCode::NEGATE:
+            case OpCode::NOT:
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+            case OpCode::RETURN:
+                popped = 1;
+                break;
+            default:
+                break;
+        }
+        if (stack.size() < popped) return false;
+
+        std::vector<size_t> next;
+        switch (op) {
+            case OpCode::CONSTANT: {
+                Value value = chunk.constants[inst.b];
+                if (value.is_number()) {
+                    stack.push_back(Type::NUMBER);
+                } else if (value.is_bool()) {
+                    stack.push_back(Type::BOOL);
+                } else if (value.is_none()) {
+                    stack.push_back(Type::NONE);
+                } else {
+                    return false;
+                }
+                next = {at + 1};
+                break;
+            }
+            case OpCode::NONE:
+                stack.push_back(Type::NONE);
+                next = {at + 1};
+                break;
+            case OpCode::POP:
+                stack.pop_back();
+                next = {at + 1};
+                break;
+            case OpCode::GET_LOCAL: {
+                Type type = state.slots[inst.b];
+                if (type == Type::UNSET || type == Type::CONFLICT) {
+                    return false;
+                }
+                stack.push_back(type);
+                next = {at + 1};
+                break;
+            }
+            case OpCode::SET_LOCAL:
+                state.slots[inst.b] = stack.back();
+                stack.pop_back();
+                next = {at + 1};
+                break;
+            case OpCode::SET_LOCAL_ATTR: {
+                // only a store that can't change the attribute's type
+                Type type = state.slots[inst.b];
+                if (type != Type::NONE && type != stack.back()) return false;
+                state.slots[inst.b] = stack.back();
+                stack.pop_back();
+                next = {at + 1};
+                break;
+            }
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL:
+            case OpCode::DIV: {
+                if (stack[stack.size() - 1] != Type::NUMBER ||
+                    stack[stack.size() - 2] != Type::NUMBER) {
+                    return false;
+                }
+                stack.pop_back();
+                next = {at + 1};
+                break;
+            }
+            case OpCode::LT:
+            case OpCode::GT:
+            case OpCode::LOT:
+            case OpCode::GOT:
+            case OpCode::EQUALS:
+            case OpCode::NOT_EQUAL: {
+                Type type = compare_type(
+                    op, stack[stack.size() - 2], stack.back());
+                if (type == Type::CONFLICT) return false;
+                stack.pop_back();
+                stack.back() = type;
+                next = {at + 1};
+                break;
+            }
+            case OpCode::NEGATE:
+                if (stack.back() != Type::NUMBER) return false;
+                next = {at + 1};
+                break;
+            case OpCode::CHECK_TYPE:
+                // only a number always fits a number, the JIT has no
+                // TYPE_ERRORs to raise
+                if ((Annotation)inst.a != Annotation::NUMBER ||
+                    stack.back() != Type::NUMBER) {
+                    return false;
+                }
+                next = {at + 1};
+                break;
+            case OpCode::NOT:
+                if (stack.back() != Type::BOOL) return false;
+                next = {at + 1};
+                break;
+            case OpCode::JUMP:
+            case OpCode::LOOP:
+                next = {inst.b};
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                if (stack.back() != Type::BOOL) return false;
+                stack.pop_back();
+                next = {at + 1, inst.b};
+                break;
+            case OpCode::JUMP_LT:
+            case OpCode::JUMP_GT:
+            case OpCode::JUMP_LOT:
+            case OpCode::JUMP_GOT:
+            case OpCode::JUMP_EQUALS:
+            case OpCode::JUMP_NOT_EQUAL: {
+                Type type = compare_type(compare_of(op),
+                                         stack[stack.size() - 2],
+                                         stack.back());
+                if (type == Type::CONFLICT) return false;
+                stack.resize(stack.size() - 2);
+                next = {at + 1, inst.b};
+                break;
+            }
+            case OpCode::RETURN:
+                break;
+            default:
+                // globals, objects, calls...
+                return false;
+        }
+        max_depth = std::max(max_depth, stack.size());
+
+        for (size_t to : next) {
+            if (to >= chunk.code.size()) return false;
+            changed = false;
+            if (!merge(states[to], state, changed)) return false;
+            if (changed) worklist.push_back(to);
+        }
+    }
+    return true;
+}
+
+// condition codes, jcc is 0x0f 0x80 + cc and setcc is 0x0f 0x90 + cc
+enum Cond : uint8_t {
+    CC_B = 0x2,
+    CC_AE = 0x3,
+    CC_E = 0x4,
+    CC_NE = 0x5,
+    CC_BE = 0x6,
+    CC_A = 0x7,
+    CC_P = 0xa,
+    CC_NP = 0xb,
+};
+
+// just enough of an x86-64 encoder for the templates below. rdi holds the
+// frame's slots and the operand stack lives under rsp
+class Assembler {
+  public:
+    std::vector<uint8_t> code;
+
+    void bytes(std::initializer_list<uint8_t> list) {
+        code.insert(code.end(), list);
+    }
+    void imm32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) code.push_back(value >> (8 * i));
+    }
+    void imm64(uint64_t value) {
+        for (int i = 0; i < 8; ++i) code.push_back(value >> (8 * i));
+    }
+
+    // mov rax/rcx, value
+    void mov_rax(uint64_t value) {
+        bytes({0x48, 0xb8});
+        imm64(value);
+    }
+    void mov_rcx(uint64_t value) {
+        bytes({0x48, 0xb9});
+        imm64(value);
+    }
+    // mov rax/rcx, [rsp + 8 * index] and back
+    void load_rax(size_t index) {
+        bytes({0x48, 0x8b, 0x84, 0x24});
+        imm32(8 * index);
+    }
+    void load_rcx(size_t index) {
+        bytes({0x48, 0x8b, 0x8c, 0x24});
+        imm32(8 * index);
+    }
+    void store_rax(size_t index) {
+        bytes({0x48, 0x89, 0x84, 0x24});
+        imm32(8 * index);
+    }
+    // mov rax, [rdi + 8 * slot] and back
+    void load_slot(uint32_t slot) {
+        bytes({0x48, 0x8b, 0x87});
+        imm32(8 * slot);
+    }
+    void store_slot(uint32_t slot) {
+        bytes({0x48, 0x89, 0x87});
+        imm32(8 * slot);
+    }
+    // movsd xmm0/xmm1, [rsp + 8 * index] and back
+    void load_xmm0(size_t index) {
+        bytes({0xf2, 0x0f, 0x10, 0x84, 0x24});
+        imm32(8 * index);
+    }
+    void load_xmm1(size_t index) {
+        bytes({0xf2, 0x0f, 0x10, 0x8c, 0x24});
+        imm32(8 * index);
+    }
+    void store_xmm0(size_t index) {
+        bytes({0xf2, 0x0f, 0x11, 0x84, 0x24});
+        imm32(8 * index);
+    }
+
+    // jmp/jcc rel32, returns where the offset goes
+    size_t jump() {
+        bytes({0xe9});
+        imm32(0);
+        return code.size() - 4;
+    }
+    size_t jump_if(Cond cond) {
+        bytes({0x0f, (uint8_t)(0x80 + cond)});
+        imm32(0);
+        return code.size() - 4;
+    }
+    void patch(size_t at, size_t target) {
+        uint32_t offset = target - (at + 4);
+        std::memcpy(code.data() + at, &offset, 4);
+    }
+};
+
+// a number result in xmm0 becomes the one NaN Value::number() produces
+void canonicalize(Assembler &as) {
+    // ucomisd xmm0, xmm0 ; jnp done
+    as.bytes({0x66, 0x0f, 0x2e, 0xc0, 0x7b, 0x0f});
+    as.mov_rax(Value::number(NAN).raw());
+    // movq xmm0, rax
+    as.bytes({0x66, 0x48, 0x0f, 0x6e, 0xc0});
+}
+
+// sets the flags for left op right, the result is then `when_true` or
+// ZF && !PF for a number (in)equality
+struct Compare {
+    Cond when_true;
+    Cond when_false;
+    // ordered equality needs two flags
+    bool equality;
+    bool negated;
+};
+
+Compare emit_compare(Assembler &as, OpCode op, Type type, size_t left) {
+    if (type == Type::BOOL) {
+        // cmp rax, rcx
+        as.load_rax(left);
+        as.load_rcx(left + 1);
+        as.bytes({0x48, 0x39, 0xc8});
+        if (op == OpCode::EQUALS) return {CC_E, CC_NE, false, false};
+        return {CC_NE, CC_E, false, false};
+    }
+    as.load_xmm0(left);
+    as.load_xmm1(left + 1);
+    // a NaN operand is unordered, which sets CF, ZF and PF, so every
+    // condition below is false for it except !=
+    switch (op) {
+        case OpCode::LT:
+            // ucomisd xmm1, xmm0
+            as.bytes({0x66, 0x0f, 0x2e, 0xc8});
+            return {CC_A, CC_BE, false, false};
+        case OpCode::LOT:
+            as.bytes({0x66, 0x0f, 0x2e, 0xc8});
+            return {CC_AE, CC_B, false, false};
+        case OpCode::GT:
+            // ucomisd xmm0, xmm1
+            as.bytes({0x66, 0x0f, 0x2e, 0xc1});
+            return {CC_A, CC_BE, false, false};
+        case OpCode::GOT:
+            as.bytes({0x66, 0x0f, 0x2e, 0xc1});
+            return {CC_AE, CC_B, false, false};
+        case OpCode::EQUALS:
+            as.bytes({0x66, 0x0f, 0x2e, 0xc1});
+            return {CC_E, CC_NE, true, false};
+        default:
+            as.bytes({0x66, 0x0f, 0x2e, 0xc1});
+            return {CC_E, CC_NE, true, true};
+    }
+}
+
+// the outcome of a compare as a bool Value in rax
+void materialize(Assembler &as, const Compare &compare) {
+    if (compare.equality) {
+        // sete al ; setnp cl ; and al, cl    (or setne, setp, or)
+        if (!compare.negated) {
+            as.bytes({0x0f, 0x94, 0xc0, 0x0f, 0x9b, 0xc1, 0x20, 0xc8});
+        } else {
+            as.bytes({0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8});
+        }
+    } else {
+        as.bytes({0x0f, (uint8_t)(0x90 + compare.when_true), 0xc0});
+    }
+    // movzx eax, al ; the two bools only differ in the lowest bit
+    as.bytes({0x0f, 0xb6, 0xc0});
+    as.mov_rcx(Value::boolean(false).raw());
+    // add rax, rcx
+    as.bytes({0x48, 0x01, 0xc8});
+}
+
+// jumps to target when the compare's outcome is `when`
+void branch(Assembler &as, const Compare &compare, bool when,
+            size_t target, std::vector<std::pair<size_t, size_t>> &jumps) {
+    if (!compare.equality) {
+        Cond cond = when ? compare.when_true : compare.when_false;
+        jumps.push_back({as.jump_if(cond), target});
+        return;
+    }
+    // equal means ZF && !PF
+    bool equal = when != compare.negated;
+    if (equal) {
+        // jp over the je
+        as.bytes({0x7a, 0x06});
+        jumps.push_back({as.jump_if(CC_E), target});
+    } else {
+        jumps.push_back({as.jump_if(CC_NE), target});
+        jumps.push_back({as.jump_if(CC_P), target});
+    }
+}
+
+bool assemble(const Function &function, const std::vector<State> &states,
+              size_t max_depth, Assembler &as) {
+    const Chunk &chunk = function.chunk;
+    uint32_t frame = 8 * max_depth;
+    // sub rsp, frame
+    as.bytes({0x48, 0x81, 0xec});
+    as.imm32(frame);
+
+    std::vector<size_t> offsets(chunk.code.size());
+    // (where the rel32 goes, instruction it points at)
+    std::vector<std::pair<size_t, size_t>> jumps;
+    for (size_t at = 0; at < chunk.code.size(); ++at) {
+        offsets[at] = as.code.size();
+        const State &state = states[at];
+        // never runs
+        if (!state.reached) continue;
+        const Instruction &inst = chunk.code[at];
+        OpCode op = base_op(inst.op);
+        size_t top = state.stack.size();
+        switch (op) {
+            case OpCode::CONSTANT: {
+                // machine code only does doubles
+                Value value = chunk.constants[inst.b];
+                if (value.is_int()) value = Value::number(value.as_number());
+                as.mov_rax(value.raw());
+                as.store_rax(top);
+                break;
+            }
+            case OpCode::NONE:
+                as.mov_rax(Value::none().raw());
+                as.store_rax(top);
+                break;
+            case OpCode::POP:
+                break;
+            case OpCode::GET_LOCAL:
+                as.load_slot(inst.b);
+                as.store_rax(top);
+                break;
+            case OpCode::SET_LOCAL:
+            case OpCode::SET_LOCAL_ATTR:
+                as.load_rax(top - 1);
+                as.store_slot(inst.b);
+                break;
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL: {
+                static constexpr uint8_t ops[] = {0x58, 0x5c, 0x59};
+                as.load_xmm0(top - 2);
+                as.load_xmm1(top - 1);
+                // addsd/subsd/mulsd xmm0, xmm1
+                uint8_t sse = ops[(int)op - (int)OpCode::ADD];
+                as.bytes({0xf2, 0x0f, sse, 0xc1});
+                canonicalize(as);
+                as.store_xmm0(top - 2);
+                break;
+            }
+            case OpCode::DIV: {
+                // dividing by zero gives 0, see number_op()
+                as.load_xmm0(top - 2);
+                as.load_xmm1(top - 1);
+                // xorpd xmm2, xmm2 ; ucomisd xmm1, xmm2
+                as.bytes({0x66, 0x0f, 0x57, 0xd2, 0x66, 0x0f, 0x2e, 0xca});
+                // jp divide ; jne divide ; xorpd xmm0, xmm0 ; jmp done
+                // divide: divsd xmm0, xmm1 ; done:
+                as.bytes({0x7a, 0x08, 0x75, 0x06, 0x66, 0x0f, 0x57, 0xc0});
+                as.bytes({0xeb, 0x04, 0xf2, 0x0f, 0x5e, 0xc1});
+                canonicalize(as);
+                as.store_xmm0(top - 2);
+                break;
+            }
+            case OpCode::CHECK_TYPE:
+                // the analysis proved it always passes
+                break;
+            case OpCode::NEGATE:
+                as.load_rax(top - 1);
+                as.mov_rcx(Value::number(-0.0).raw());
+                // xor rax, rcx ; movq xmm0, rax
+                as.bytes({0x48, 0x31, 0xc8, 0x66, 0x48, 0x0f, 0x6e, 0xc0});
+                canonicalize(as);
+                as.store_xmm0(top - 1);
+                break;
+            case OpCode::NOT:
+                as.load_rax(top - 1);
+                // xor rax, 1
+                as.bytes({0x48, 0x83, 0xf0, 0x01});
+                as.store_rax(top - 1);
+                break;
+            case OpCode::LT:
+            case OpCode::GT:
+            case OpCode::LOT:
+            case OpCode::GOT:
+            case OpCode::EQUALS:
+            case OpCode::NOT_EQUAL: {
+                Compare compare = emit_compare(
+                    as, op, state.stack[top - 2], top - 2);
+                materialize(as, compare);
+                as.store_rax(top - 2);
+                break;
+            }
+            case OpCode::JUMP:
+            case OpCode::LOOP:
+                jumps.push_back({as.jump(), inst.b});
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE: {
+                as.load_rax(top - 1);
+                as.mov_rcx(Value::boolean(true).raw());
+                // cmp rax, rcx
+                as.bytes({0x48, 0x39, 0xc8});
+                Cond cond = op == OpCode::JUMP_IF_TRUE ? CC_E : CC_NE;
+                jumps.push_back({as.jump_if(cond), inst.b});
+                break;
+            }
+            case OpCode::JUMP_LT:
+            case OpCode::JUMP_GT:
+            case OpCode::JUMP_LOT:
+            case OpCode::JUMP_GOT:
+            case OpCode::JUMP_EQUALS:
+            case OpCode::JUMP_NOT_EQUAL: {
+                Compare compare = emit_compare(
+                    as, compare_of(op), state.stack[top - 2], top - 2);
+                branch(as, compare, inst.a, inst.b, jumps);
+                break;
+            }
+            case OpCode::RETURN:
+                as.load_rax(top - 1);
+                // add rsp, frame ; ret
+                as.bytes({0x48, 0x81, 0xc4});
+                as.imm32(frame);
+                as.bytes({0xc3});
+                break;
+            default:
+                return false;
+        }
+    }
+    for (const auto &[at, target] : jumps) {
+        as.patch(at, offsets[target]);
+    }
+    return true;
+}
+
+} // namespace
+
+JitFn Jit::compile(const Function &original) {
+    // a scratch copy with the fused instructions split up
+    Function function;
+    function.params = original.params;
+    function.slots = original.slots;
+    function.chunk.constants = original.chunk.constants;
+    function.chunk.code = unfuse(original.chunk.code);
+    std::vector<State> states;
+    size_t max_depth = 0;
+    if (function.chunk.code.empty() ||
+        !analyze(function, states, max_depth)) {
+        return nullptr;
+    }
+    Assembler as;
+    if (!assemble(function, states, max_depth, as)) return nullptr;
+
+    // written while writable, then flipped to executable
+    size_t size = as.code.size();
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, as.code.data(), size);
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    regions.push_back({memory, size});
+    return reinterpret_cast<JitFn>(memory);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef RUNTIME_JIT_HPP
+#define RUNTIME_JIT_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "compiler/bytecode.hpp"
+
+// the JIT only has an x86-64 backend, elsewhere compile() always fails and
+// everything stays in the interpreter
+#if defined(__x86_64__) && defined(__linux__)
+#define CHOCO_JIT 1
+#else
+#define CHOCO_JIT 0
+#endif
+
+// baseline template JIT for hot confections: a function whose bytecode only
+// does number/bool arithmetic, comparisons, locals and jumps is checked
+// once, assuming every parameter is a number, and each instruction is then
+// pasted in as a fixed sequence of machine code. The caller guards the
+// argument types and runs the interpreter when they don't hold
+class Jit {
+  public:
+    Jit() = default;
+    Jit(const Jit &) = delete;
+    Jit &operator=(const Jit &) = delete;
+    ~Jit();
+
+    // nullptr if function uses anything the JIT can't type statically
+    JitFn compile(const Function &function);
+
+  private:
+    struct Region {
+        void *memory;
+        size_t size;
+    };
+    // executable pages, released with the Jit
+    std::vector<Region> regions;
+};
+
+#endif // RUNTIME_JIT_HPP
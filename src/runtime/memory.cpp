@@ -8,3 +8,11 @@ Memory::~Memory() {
         pointers.pop_back();
     }
 }
+
+Value copy(Memory &memory, Value s) {
+    if (s.type() == ValueType::STRING) {
+        return Value::object(memory.get<StringValue>(as_string(s)));
+    }
+    // list and objects are references
+    return s;
+}
@@ -1,6 +1,7 @@
 #ifndef RUNTIME_MEMORY_HPP
 #define RUNTIME_MEMORY_HPP
 
+#include <utility>
 #include <vector>
 
 #include "runtime/value.hpp"
@@ -14,15 +15,19 @@ class Memory {
     template <typename T, typename... Args>
     T *get(Args &&...args) {
         // Compile-time sanity check
-        static_assert(std::is_base_of<LiteralValue, T>::value,
-                      "T not derived from LiteralValue");
-        T *ptr = new T(args...);
+        static_assert(std::is_base_of<HeapValue, T>::value,
+                      "T not derived from HeapValue");
+        T *ptr = new T(std::forward<Args>(args)...);
         pointers.push_back(ptr);
         return ptr;
     }
 
   private:
-    std::vector<LiteralValue *> pointers;
+    std::vector<HeapValue *> pointers;
 };
 
+// strings are copied, lists and objects are references, numbers and bools
+// are immediates and copy themselves
+Value copy(Memory &memory, Value s);
+
 #endif // RUNTIME_MEMORY_HPP
@@ -0,0 +1,192 @@
+#include "natives.hpp"
+
+#include <fmt/core.h>
+
+#include <cmath>
+#include <iostream>
+
+#include "util/error.hpp"
+
+void NativeRegistry::define(const std::string &name, NativeFn fn, int arity) {
+    indices[name] = natives.size();
+    natives.push_back({name, fn, arity});
+}
+
+int64_t NativeRegistry::find(const std::string &name) const {
+    auto it = indices.find(name);
+    if (it == indices.end()) return -1;
+    return it->second;
+}
+
+// INFO: predefined STDIO functions
+static Value print(Memory &, std::span<const Value> args) {
+    if (args.size() == 0) {
+        fmt::println("");
+    } else {
+        fmt::println("{}", args.front());
+    }
+    return Value::none();
+}
+
+static Value input(Memory &memory, std::span<const Value> args) {
+    // print the prompt
+    print(memory, args);
+    // get the different values
+    std::string in;
+    std::cin >> in;
+    return Value::object(memory.get<StringValue>(in));
+}
+
+// math funcs
+static Value abs(Memory &, std::span<const Value> args) {
+    return Value::number(std::abs(as_double(args[0])));
+}
+
+static Value sign(Memory &, std::span<const Value> args) {
+    double v = as_double(args[0]);
+    return Value::number(v / std::abs(v));
+}
+
+static Value pow(Memory &, std::span<const Value> args) {
+    return Value::number(std::pow(as_double(args[0]), as_double(args[1])));
+}
+
+static Value sin(Memory &, std::span<const Value> args) {
+    return Value::number(std::sin(as_double(args[0])));
+}
+
+static Value cos(Memory &, std::span<const Value> args) {
+    return Value::number(std::cos(as_double(args[0])));
+}
+
+static Value tan(Memory &, std::span<const Value> args) {
+    return Value::number(std::tan(as_double(args[0])));
+}
+
+static Value sqrt(Memory &, std::span<const Value> args) {
+    return Value::number(std::sqrt(as_double(args[0])));
+}
+
+static Value round(Memory &, std::span<const Value> args) {
+    return Value::number(std::round(as_double(args[0])));
+}
+
+static Value ceil(Memory &, std::span<const Value> args) {
+    return Value::number(std::ceil(as_double(args[0])));
+}
+
+static Value floor(Memory &, std::span<const Value> args) {
+    return Value::number(std::floor(as_double(args[0])));
+}
+
+// array/string methods
+static Value len(Memory &, std::span<const Value> args) {
+    Value v = args[0];
+    if (v.type() == ValueType::LIST)
+        return Value::integer(v.as<ListValue>()->value.size());
+    if (v.type() == ValueType::STRING)
+        return Value::integer(v.as<StringValue>()->value.size());
+    throw Error(Error::INVALID_ARGUMENT_ERROR, "Expected list or string type.");
+}
+
+size_t element_index(Value index, size_t length) {
+    // counters and indices are ints, they never need a double compare
+    if (index.is_int() && index.as_int() >= 0 &&
+        (size_t)index.as_int() < length) {
+        return index.as_int();
+    }
+    if (!index.is_number()) {
+        throw Error(Error::TYPE_ERROR, "Error: Index must be a number.");
+    }
+    double i = index.as_number();
+    if (!(i >= 0 && i < length) || i != std::floor(i)) {
+        throw Error(Error::INDEX_ERROR,
+                    fmt::format("Error: Index {} out of range for length {}.",
+                                i, length));
+    }
+    return i;
+}
+
+static Value get(Memory &memory, std::span<const Value> args) {
+    Value container = args[0];
+    if (container.type() == ValueType::LIST) {
+        const auto &list = container.as<ListValue>()->value;
+        return list[element_index(args[1], list.size())];
+    }
+    if (container.type() == ValueType::STRING) {
+        const std::string &value = container.as<StringValue>()->value;
+        std::string str{value[element_index(args[1], value.size())]};
+        return Value::object(memory.get<StringValue>(str));
+    }
+    throw Error(Error::INVALID_ARGUMENT_ERROR, "Expected list or string type.");
+}
+
+static Value append(Memory &, std::span<const Value> args) {
+    Value container = args[0];
+    Value v = args[1];
+    if (container.type() == ValueType::LIST) {
+        container.as<ListValue>()->value.push_back(v);
+        return Value::none();
+    }
+    if (container.type() == ValueType::STRING) {
+        const std::string &str_to_add = as_string(v);
+        container.as<StringValue>()->value.append(str_to_add);
+        return Value::none();
+    }
+    throw Error(Error::INVALID_ARGUMENT_ERROR, "Expected list or string type.");
+}
+
+static Value pop(Memory &, std::span<const Value> args) {
+    Value container = args[0];
+    if (container.type() == ValueType::LIST) {
+        container.as<ListValue>()->value.pop_back();
+        return Value::none();
+    }
+    if (container.type() == ValueType::STRING) {
+        container.as<StringValue>()->value.pop_back();
+        return Value::none();
+    }
+    throw Error(Error::INVALID_ARGUMENT_ERROR, "Expected list or string type.");
+}
+
+static Value insert(Memory &, std::span<const Value> args) {
+    Value container = args[0];
+    Value elem = args[2];
+    if (container.type() == ValueType::LIST) {
+        auto &vec = container.as<ListValue>()->value;
+        // inserting at the end is allowed
+        size_t idx = element_index(args[1], vec.size() + 1);
+        vec.insert(vec.begin() + idx, elem);
+        return Value::none();
+    }
+    if (container.type() == ValueType::STRING) {
+        const std::string &str_to_add = as_string(elem);
+        auto &str = container.as<StringValue>()->value;
+        size_t idx = element_index(args[1], str.size() + 1);
+        str.insert(idx, str_to_add);
+        return Value::none();
+    }
+    throw Error(Error::INVALID_ARGUMENT_ERROR, "Expected list or string type.");
+}
+
+void define_core_natives(NativeRegistry &registry) {
+    registry.define("print", print, -1);
+    registry.define("input", input, -1);
+
+    registry.define("abs", abs, 1);
+    registry.define("sign", sign, 1);
+    registry.define("pow", pow, 2);
+    registry.define("sin", sin, 1);
+    registry.define("cos", cos, 1);
+    registry.define("tan", tan, 1);
+    registry.define("sqrt", sqrt, 1);
+    registry.define("round", round, 1);
+    registry.define("ceil", ceil, 1);
+    registry.define("floor", floor, 1);
+
+    registry.define("len", len, 1);
+    registry.define("get", get, 2);
+    registry.define("append", append, 2);
+    registry.define("pop", pop, 1);
+    registry.define("insert", insert, 3);
+}
@@ -0,0 +1,49 @@
+#ifndef RUNTIME_NATIVES_HPP
+#define RUNTIME_NATIVES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime/memory.hpp"
+#include "runtime/value.hpp"
+
+// the argument count is checked by the Resolver, natives can index args
+// directly
+using NativeFn = Value (*)(Memory &memory, std::span<const Value> args);
+
+struct Native {
+    std::string name;
+    NativeFn fn;
+    // -1 accepts any number of arguments
+    int arity;
+};
+
+// builtins by name, call sites are bound to an index into it once before
+// running
+class NativeRegistry {
+  public:
+    void define(const std::string &name, NativeFn fn, int arity);
+    // returns -1 if there is no native called name
+    int64_t find(const std::string &name) const;
+
+    const Native &operator[](uint32_t index) const {
+        return natives[index];
+    }
+
+  private:
+    std::vector<Native> natives;
+    std::unordered_map<std::string, uint32_t> indices;
+};
+
+// the position container[index] refers to, an INDEX_ERROR unless index is
+// a whole number in [0, length)
+size_t element_index(Value index, size_t length);
+
+// stdio, math and list/string builtins
+void define_core_natives(NativeRegistry &registry);
+
+#endif // RUNTIME_NATIVES_HPP
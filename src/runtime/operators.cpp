@@ -0,0 +1,168 @@
+#include "operators.hpp"
+
+#include <fmt/core.h>
+
+#include <string>
+
+#include "runtime/natives.hpp"
+#include "util/error.hpp"
+
+Value binary_op(Memory &memory, TokenType op, Value left, Value right) {
+    Value result;
+    if (left.is_number() && right.is_number()) {
+        if (numeric_op(op, left, right, result)) {
+            return result;
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid numerical operation '{}'.", op));
+    }
+
+    ValueType ltype = left.type();
+    ValueType rtype = right.type();
+    if (ltype == ValueType::STRING && rtype == ValueType::STRING) {
+        const std::string &lval = left.as<StringValue>()->value;
+        const std::string &rval = right.as<StringValue>()->value;
+        if (op == TokenType::PLUS) {
+            return Value::object(memory.get<StringValue>(lval + rval));
+        }
+        if (op == TokenType::EQUALS) {
+            return Value::boolean(lval == rval);
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid string operation '{}'.", op));
+    }
+    // string concatenation
+    if (ltype == ValueType::STRING && rtype == ValueType::NUMBER) {
+        if (op == TokenType::PLUS) {
+            // remove unnecessary digits in string by rounding
+            return Value::object(memory.get<StringValue>(
+                left.as<StringValue>()->value + literal_to_string(right)));
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid string-number operation '{}'.", op));
+    }
+    if (ltype == ValueType::NUMBER && rtype == ValueType::STRING) {
+        if (op == TokenType::PLUS) {
+            // remove unnecessary digits in string by rounding
+            return Value::object(memory.get<StringValue>(
+                literal_to_string(left) + right.as<StringValue>()->value));
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid number-string operation '{}'.", op));
+    }
+
+    if (ltype == ValueType::STRING && rtype == ValueType::BOOL) {
+        if (op == TokenType::PLUS) {
+            return Value::object(memory.get<StringValue>(
+                left.as<StringValue>()->value +
+                (right.as_bool() ? "true" : "false")));
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid string-bool operation '{}'.", op));
+    }
+    if (ltype == ValueType::BOOL && rtype == ValueType::STRING) {
+        if (op == TokenType::PLUS) {
+            return Value::object(memory.get<StringValue>(
+                (left.as_bool() ? "true" : "false") +
+                right.as<StringValue>()->value));
+        }
+        throw Error(
+            Error::TYPE_ERROR,
+            fmt::format("Error: Invalid bool-string operation '{}'.", op));
+    }
+
+    // comparison/boolean operators
+    if (ltype == ValueType::BOOL && rtype == ValueType::BOOL) {
+        if (bool_op(op, left.as_bool(), right.as_bool(), result)) {
+            return result;
+        }
+        return Value::boolean(false);
+    }
+    throw Error(Error::TYPE_ERROR,
+                fmt::format("Error: Invalid operation '{}'.", op));
+}
+
+Value add_in_place(Memory &memory, Value left, Value right) {
+    if (left.is_number() && right.is_number()) {
+        Value result;
+        numeric_op(TokenType::PLUS, left, right, result);
+        return result;
+    }
+    // the string grows, nothing new is allocated
+    if (left.type() == ValueType::STRING) {
+        std::string &value = left.as<StringValue>()->value;
+        if (right.type() == ValueType::STRING) {
+            value += right.as<StringValue>()->value;
+            return left;
+        }
+        if (right.is_number()) {
+            append_number(value, right);
+            return left;
+        }
+        if (right.is_bool()) {
+            value += right.as_bool() ? "true" : "false";
+            return left;
+        }
+    }
+    return binary_op(memory, TokenType::PLUS, left, right);
+}
+
+// a value + can turn into text
+static bool is_piece(Value value) {
+    ValueType type = value.type();
+    return type == ValueType::STRING || type == ValueType::NUMBER ||
+           type == ValueType::BOOL;
+}
+
+static void append_piece(std::string &out, Value value) {
+    if (value.is_number()) {
+        append_number(out, value);
+    } else if (value.is_bool()) {
+        out += value.as_bool() ? "true" : "false";
+    } else {
+        out += value.as<StringValue>()->value;
+    }
+}
+
+Value concat(Memory &memory, Value left, Value right, size_t size) {
+    bool text = left.type() == ValueType::STRING ||
+                right.type() == ValueType::STRING;
+    if (!text || !is_piece(left) || !is_piece(right)) {
+        return binary_op(memory, TokenType::PLUS, left, right);
+    }
+    std::string result;
+    result.reserve(size);
+    append_piece(result, left);
+    append_piece(result, right);
+    return Value::object(memory.get<StringValue>(std::move(result)));
+}
+
+Value get_index(Memory &memory, Value container, Value index) {
+    if (container.type() == ValueType::LIST) {
+        const auto &list = container.as<ListValue>()->value;
+        return list[element_index(index, list.size())];
+    }
+    if (container.type() == ValueType::STRING) {
+        const std::string &value = container.as<StringValue>()->value;
+        std::string str{value[element_index(index, value.size())]};
+        return Value::object(memory.get<StringValue>(str));
+    }
+    throw Error(Error::TYPE_ERROR,
+                "Error: Only lists and strings can be indexed.");
+}
+
+void set_index(Memory &memory, Value container, Value index, Value value) {
+    // strings can only be changed through their natives
+    if (container.type() != ValueType::LIST) {
+        throw Error(Error::TYPE_ERROR,
+                    "Error: Only list elements can be assigned to.");
+    }
+    auto &list = container.as<ListValue>()->value;
+    // stored like an attribute, strings are copied
+    list[element_index(index, list.size())] = copy(memory, value);
+}
@@ -0,0 +1,148 @@
+#ifndef RUNTIME_OPERATORS_HPP
+#define RUNTIME_OPERATORS_HPP
+
+#include "runtime/memory.hpp"
+#include "runtime/value.hpp"
+#include "token.hpp"
+
+// the operators on immediates, shared by the VM and the Optimizer's constant
+// folding so both always agree
+
+// false if op is not a number operator
+inline bool number_op(TokenType op, double left, double right, Value &result) {
+    switch (op) {
+        // arithmetic operators
+        case TokenType::PLUS:
+            result = Value::number(left + right);
+            return true;
+        case TokenType::MINUS:
+            result = Value::number(left - right);
+            return true;
+        case TokenType::MUL:
+            result = Value::number(left * right);
+            return true;
+        case TokenType::DIV:
+            result = Value::number(right != 0.0 ? left / right : 0.0);
+            return true;
+        // boolean operators
+        case TokenType::LT:
+            result = Value::boolean(left < right);
+            return true;
+        case TokenType::GT:
+            result = Value::boolean(left > right);
+            return true;
+        case TokenType::LOT:
+            result = Value::boolean(left <= right);
+            return true;
+        case TokenType::GOT:
+            result = Value::boolean(left >= right);
+            return true;
+        case TokenType::EQUALS:
+            result = Value::boolean(left == right);
+            return true;
+        case TokenType::NOT_EQUAL:
+            result = Value::boolean(left != right);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// number_op for two ints: added, subtracted, multiplied and compared as
+// ints and divided as ints when the division is exact. A result that
+// overflows an int is computed as a double instead
+inline bool int_op(TokenType op, int32_t left, int32_t right, Value &result) {
+    // no int32 operation overflows an int64
+    int64_t n;
+    switch (op) {
+        case TokenType::PLUS:
+            n = (int64_t)left + right;
+            if (n != (int32_t)n) break;
+            result = Value::int32(n);
+            return true;
+        case TokenType::MINUS:
+            n = (int64_t)left - right;
+            if (n != (int32_t)n) break;
+            result = Value::int32(n);
+            return true;
+        case TokenType::MUL:
+            n = (int64_t)left * right;
+            if (n != (int32_t)n) break;
+            result = Value::int32(n);
+            return true;
+        case TokenType::DIV:
+            // INT32_MIN / -1 is the only quotient that overflows
+            if (right == 0 || left % (int64_t)right != 0) break;
+            result = Value::integer((int64_t)left / right);
+            return true;
+        case TokenType::LT:
+            result = Value::boolean(left < right);
+            return true;
+        case TokenType::GT:
+            result = Value::boolean(left > right);
+            return true;
+        case TokenType::LOT:
+            result = Value::boolean(left <= right);
+            return true;
+        case TokenType::GOT:
+            result = Value::boolean(left >= right);
+            return true;
+        case TokenType::EQUALS:
+            result = Value::boolean(left == right);
+            return true;
+        case TokenType::NOT_EQUAL:
+            result = Value::boolean(left != right);
+            return true;
+        default:
+            return false;
+    }
+    return number_op(op, left, right, result);
+}
+
+// false if op is not a number operator, for any two numbers
+inline bool numeric_op(TokenType op, Value left, Value right, Value &result) {
+    if (left.is_int() && right.is_int()) {
+        return int_op(op, left.as_int(), right.as_int(), result);
+    }
+    return number_op(op, left.as_number(), right.as_number(), result);
+}
+
+// false if op is not a bool operator
+inline bool bool_op(TokenType op, bool left, bool right, Value &result) {
+    switch (op) {
+        case TokenType::AND:
+            result = Value::boolean(left && right);
+            return true;
+        case TokenType::OR:
+            result = Value::boolean(left || right);
+            return true;
+        case TokenType::EQUALS:
+            result = Value::boolean(left == right);
+            return true;
+        case TokenType::NOT_EQUAL:
+            result = Value::boolean(left != right);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// the operators on any values, shared by the VM and the programs of
+// `choco --emit-cpp`. Each throws the TYPE_ERROR a script sees
+
+// a generic ADD to NOT_EQUAL, strings are concatenated with whatever is on
+// the other side
+Value binary_op(Memory &memory, TokenType op, Value left, Value right);
+// left + right where left is the string a CONCAT just made, nothing else
+// holds it so it is appended to and returned instead of copied
+Value add_in_place(Memory &memory, Value left, Value right);
+// left + right at the start of a chain of +s that makes a string (see
+// ConcatChain), the new string has room for size characters so the rest of
+// the chain is appended to it in place
+Value concat(Memory &memory, Value left, Value right, size_t size);
+// container[index] of a list or a string
+Value get_index(Memory &memory, Value container, Value index);
+// container[index] = value of a list
+void set_index(Memory &memory, Value container, Value index, Value value);
+
+#endif // RUNTIME_OPERATORS_HPP
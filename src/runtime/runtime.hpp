@@ -4,29 +4,20 @@
 #include <string>
 #include <unordered_map>
 
-#include "ast.hpp"
+#include "compiler/bytecode.hpp"
 #include "util/util.hpp"
 #include "value.hpp"
 
 class Runtime {
   public:
     Runtime();
-    LiteralValue *get_variable_value(const std::string &name);
-    void var_define(const std::string &name, LiteralValue *value);
-    bool var_exists(const std::string &name);
 
-    FunctionDefExpr *get_func_value(const std::string &name);
-    void func_define(const std::string &name, FunctionDefExpr *function);
-    bool func_exists(const std::string &name);
-
-    ClassDefinitionExpr *get_class_value(const std::string &name);
-    void class_define(const std::string &name, ClassDefinitionExpr *function);
+    Class *get_class_value(const std::string &name);
+    void class_define(const std::string &name, Class *class_value);
     bool class_exists(const std::string &name);
 
   private:
-    std::unordered_map<std::string, LiteralValue *> variables;
-    std::unordered_map<std::string, FunctionDefExpr *> functions;
-    std::unordered_map<std::string, ClassDefinitionExpr *> class_definitions;
+    std::unordered_map<std::string, Class *> class_definitions;
 };
 
 #endif // RUNTIME_RUNTIME_HPP
@@ -1,7 +1,11 @@
 #ifndef VALUE_HPP
 #define VALUE_HPP
 
+#include <bit>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -13,180 +17,326 @@
 
 enum class ValueType { NONE = 0, BOOL, NUMBER, STRING, CLASS, LIST, OBJECT };
 
-struct LiteralValue {
-    LiteralValue() = default;
-    virtual ~LiteralValue() = default;
-    virtual void operator=(LiteralValue &other) = 0;
+// strings, lists and objects live on the heap and are owned by Memory
+struct HeapValue {
+    HeapValue() = default;
+    virtual ~HeapValue() = default;
 
     ValueType type;
 };
 
-struct NoneValue : public LiteralValue {
-    NoneValue() {
-        type = ValueType::NONE;
+// a NaN-boxed 64-bit value: any double is stored as itself, None, bools,
+// 32-bit ints and heap pointers are hidden in the payload of a quiet NaN so
+// numbers and bools never allocate. Ints and doubles are both numbers to
+// scripts, an int that would overflow becomes a double
+class Value {
+  public:
+    Value() : bits(QNAN | TAG_NONE) {}
+
+    static Value none() {
+        return Value{QNAN | TAG_NONE};
+    }
+    static Value boolean(bool b) {
+        return Value{QNAN | (b ? TAG_TRUE : TAG_FALSE)};
+    }
+    static Value number(double d) {
+        // canonicalize so a NaN result can't be mistaken for a boxed value
+        if (d != d) return Value{CANONICAL_NAN};
+        return Value{std::bit_cast<uint64_t>(d)};
+    }
+    static Value int32(int32_t n) {
+        return Value{INT_TAG | (uint32_t)n};
+    }
+    // an int if n fits in one, otherwise the closest double
+    static Value integer(int64_t n) {
+        if (n < std::numeric_limits<int32_t>::min() ||
+            n > std::numeric_limits<int32_t>::max()) {
+            return number((double)n);
+        }
+        return int32(n);
+    }
+    static Value object(HeapValue *ptr) {
+        return Value{SIGN_BIT | QNAN | (uint64_t)(uintptr_t)ptr};
+    }
+    // marks a global slot that has not been defined yet, never seen by
+    // scripts
+    static Value undefined() {
+        return Value{QNAN | TAG_UNDEFINED};
     }
-    void operator=(LiteralValue &other) override {}
-};
 
-struct BoolValue : public LiteralValue {
-    BoolValue(bool value) : value(value) {
-        type = ValueType::BOOL;
+    bool is_number() const {
+        return is_double() || is_int();
+    }
+    bool is_double() const {
+        return (bits & QNAN) != QNAN;
+    }
+    bool is_int() const {
+        // just the tag in the top 16 bits, cheaper than masking
+        return (bits >> 48) == (INT_TAG >> 48);
+    }
+    bool is_bool() const {
+        return (bits | 1) == (QNAN | TAG_TRUE);
+    }
+    bool is_none() const {
+        return bits == (QNAN | TAG_NONE);
+    }
+    bool is_object() const {
+        return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN);
+    }
+    bool is_undefined() const {
+        return bits == (QNAN | TAG_UNDEFINED);
     }
 
-    void operator=(LiteralValue &other) override {
-        if (other.type != ValueType::BOOL) {
-            throw Error(Error::TYPE_ERROR, "Cannot assign different types");
-        }
-        value = static_cast<BoolValue &>(other).value;
+    double as_number() const {
+        if (is_int()) return as_int();
+        return std::bit_cast<double>(bits);
+    }
+    int32_t as_int() const {
+        return (int32_t)(uint32_t)bits;
+    }
+    bool as_bool() const {
+        return bits == (QNAN | TAG_TRUE);
+    }
+    HeapValue *as_object() const {
+        return (HeapValue *)(uintptr_t)(bits & ~(SIGN_BIT | QNAN));
+    }
+    template <typename T>
+    T *as() const {
+        return static_cast<T *>(as_object());
     }
-    bool value;
-};
 
-struct NumValue : public LiteralValue {
-    NumValue(double value) : value(value) {
-        type = ValueType::NUMBER;
+    // the boxed representation, for code that builds Values itself (Jit)
+    uint64_t raw() const {
+        return bits;
     }
-    void operator=(LiteralValue &other) override {
-        if (other.type != ValueType::NUMBER) {
-            throw Error(Error::TYPE_ERROR, "Cannot assign different types");
-        }
-        value = static_cast<NumValue &>(other).value;
+
+    ValueType type() const {
+        if (is_number()) return ValueType::NUMBER;
+        if (is_object()) return as_object()->type;
+        if (is_bool()) return ValueType::BOOL;
+        return ValueType::NONE;
     }
 
-    double value;
+  private:
+    explicit Value(uint64_t bits) : bits(bits) {}
+
+    static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+    static constexpr uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr uint64_t CANONICAL_NAN = 0x7ff8000000000000;
+    static constexpr uint64_t TAG_NONE = 1;
+    static constexpr uint64_t TAG_FALSE = 2;
+    static constexpr uint64_t TAG_TRUE = 3;
+    static constexpr uint64_t TAG_UNDEFINED = 4;
+    // heap pointers fit in 48 bits, so bit 48 is free to mark an int
+    static constexpr uint64_t INT_TAG = QNAN | (1ull << 48);
+
+    uint64_t bits;
 };
 
-struct StringValue : public LiteralValue {
+static_assert(sizeof(Value) == sizeof(double), "Value must stay 64 bits");
+
+struct StringValue : public HeapValue {
     StringValue(const std::string &value) : value(value) {
         type = ValueType::STRING;
     }
-
-    void operator=(LiteralValue &other) override {
-        if (other.type != ValueType::STRING) {
-            throw Error(Error::TYPE_ERROR, "Cannot assign different types");
-        }
-        value = static_cast<StringValue &>(other).value;
+    StringValue(std::string &&value) : value(std::move(value)) {
+        type = ValueType::STRING;
     }
 
     std::string value;
 };
 
-struct ObjectValue : public LiteralValue {
-    ObjectValue() {
+// the layout of every instance of a box: attribute i lives in slot i
+struct Shape {
+    void add(const std::string &name) {
+        slots[name] = names.size();
+        names.push_back(name);
+    }
+    // returns -1 if there is no attribute called name
+    int64_t find(const std::string &name) const {
+        auto it = slots.find(name);
+        if (it == slots.end()) return -1;
+        return it->second;
+    }
+
+    std::vector<std::string> names;
+    // the confection slot of each method of the box, by name
+    std::unordered_map<std::string, uint32_t> methods;
+
+  private:
+    std::unordered_map<std::string, uint32_t> slots;
+};
+
+struct ObjectValue : public HeapValue {
+    ObjectValue(const Shape *shape)
+        : shape(shape), slots(shape->names.size()) {
         type = ValueType::OBJECT;
     }
-    void operator=(LiteralValue &other) override {
-        if (other.type != ValueType::OBJECT) {
-            throw Error(Error::TYPE_ERROR, "Cannot assign different types");
-        }
-        fmt::println("objbect = called");
-        // reset values and copy everything according to copy or reference rules
-        values.clear();
-        auto obj = static_cast<ObjectValue &>(other);
-        for (const auto &[key, val] : obj.values) {
-            values[key] = val;
-        }
+    ObjectValue(const Shape *shape, const std::vector<Value> &slots)
+        : shape(shape), slots(slots) {
+        type = ValueType::OBJECT;
     }
 
-    std::unordered_map<std::string, LiteralValue *> values;
+    const Shape *shape;
+    std::vector<Value> slots;
 };
 
-struct ListValue : public LiteralValue {
+struct ListValue : public HeapValue {
     ListValue() {
         type = ValueType::LIST;
     }
-    void operator=(LiteralValue &other) override {
-        if (other.type != ValueType::LIST) {
-            throw Error(Error::TYPE_ERROR, "Cannot assign different types");
-        }
-        auto list = static_cast<ListValue &>(other);
 
-        value.clear();
-        value.reserve(list.value.size());
-        for (const auto &elem : list.value) {
-            value.push_back(elem); // pass by reference
+    std::vector<Value> value;
+};
+
+// appends how a number prints to out, without a std::string of its own
+inline void append_number(std::string &out, Value value) {
+    // the longest is -DBL_MAX with the six decimals of "%f"
+    char buffer[320];
+    char *end;
+    if (value.is_int()) {
+        end = std::to_chars(buffer, std::end(buffer), value.as_int()).ptr;
+    } else {
+        double v = value.as_number();
+        // whole doubles print like ints, as long as int64 holds them
+        if (std::round(v) == v && std::abs(v) < 0x1p63) {
+            end = std::to_chars(buffer, std::end(buffer), (int64_t)v).ptr;
+        } else {
+            end = std::to_chars(buffer,
+                                std::end(buffer),
+                                v,
+                                std::chars_format::fixed,
+                                6)
+                      .ptr;
         }
     }
+    out.append(buffer, end);
+}
 
-    std::vector<LiteralValue *> value;
-};
-
-inline std::string literal_to_string(LiteralValue &value) {
-    switch (value.type) {
+inline std::string literal_to_string(Value value) {
+    switch (value.type()) {
         case ValueType::NONE:
             return "None";
         case ValueType::BOOL: {
-            auto &v = static_cast<BoolValue &>(value);
-            return v.value ? "true" : "false";
+            return value.as_bool() ? "true" : "false";
         }
         case ValueType::NUMBER: {
-            auto &v = static_cast<NumValue &>(value).value;
-            std::string num = std::to_string(v);
-            if (std::round(v) == v) {
-                num = std::to_string((int)v);
-            }
-            return num;
+            std::string text;
+            append_number(text, value);
+            return text;
         }
         case ValueType::STRING: {
-            auto &v = static_cast<StringValue &>(value);
-            return v.value;
+            return value.as<StringValue>()->value;
         }
         case ValueType::LIST: {
-            auto &v = static_cast<ListValue &>(value);
+            auto &v = *value.as<ListValue>();
             std::stringstream ss;
             ss << "[";
             for (int i = 0; i < v.value.size() - 1; ++i) {
-                ss << literal_to_string(*v.value[i]) << ", ";
+                ss << literal_to_string(v.value[i]) << ", ";
             }
-            ss << literal_to_string(*v.value.back()) << "]";
+            ss << literal_to_string(v.value.back()) << "]";
             return ss.str();
         }
         case ValueType::OBJECT: {
-            auto &v = static_cast<ObjectValue &>(value);
+            auto &v = *value.as<ObjectValue>();
             std::stringstream ss;
             ss << "[";
-            for (const auto &[key, val] : v.values) {
-                ss << key << ": " << literal_to_string(*val) << ", ";
+            for (size_t i = 0; i < v.slots.size(); ++i) {
+                ss << v.shape->names[i] << ": " << literal_to_string(v.slots[i])
+                   << ", ";
             }
             ss << "]";
             return ss.str();
         }
+        default:
+            break;
     }
     throw Error(Error::INVALID_ARGUMENT_ERROR, "Invalid literal type");
     return "";
 }
 
-inline double as_double(LiteralValue *v) {
-    if (v->type != ValueType::NUMBER)
+inline double as_double(Value v) {
+    if (!v.is_number())
         throw Error(Error::INVALID_ARGUMENT_ERROR,
                     "Invalid argument: expected number.");
-    return static_cast<NumValue *>(v)->value;
+    return v.as_number();
 }
 
-inline bool as_bool(LiteralValue *v) {
-    if (v->type != ValueType::BOOL)
+inline bool as_bool(Value v) {
+    if (!v.is_bool())
         throw Error(Error::INVALID_ARGUMENT_ERROR,
                     "Invalid argument: expected bool.");
-    return static_cast<BoolValue *>(v)->value;
+    return v.as_bool();
 }
 
-inline std::string as_string(LiteralValue *v) {
-    if (v->type != ValueType::STRING)
+inline const std::string &as_string(Value v) {
+    if (v.type() != ValueType::STRING)
         throw Error(Error::INVALID_ARGUMENT_ERROR,
                     "Invalid argument: expected string.");
-    return static_cast<StringValue *>(v)->value;
+    return v.as<StringValue>()->value;
 }
 
-inline const std::vector<LiteralValue *> &as_list(LiteralValue *v) {
-    if (v->type != ValueType::LIST)
+inline const std::vector<Value> &as_list(Value v) {
+    if (v.type() != ValueType::LIST)
         throw Error(Error::INVALID_ARGUMENT_ERROR,
                     "Invalid argument: expected list.");
-    return static_cast<ListValue *>(v)->value;
+    return v.as<ListValue>()->value;
+}
+
+// the optional type of a variable (`let int x`), every value stored in it
+// has to fit
+enum class Annotation : uint8_t {
+    NONE,
+    // float, double
+    NUMBER,
+    // int, short, long: a number without a fraction
+    WHOLE,
+    // unsigned: a whole number that isn't negative
+    UNSIGNED,
+    // char: a string of one character
+    CHAR
+};
+
+inline const char *annotation_name(Annotation type) {
+    switch (type) {
+        case Annotation::NUMBER:
+            return "number";
+        case Annotation::WHOLE:
+            return "whole number";
+        case Annotation::UNSIGNED:
+            return "non-negative whole number";
+        case Annotation::CHAR:
+            return "single character";
+        default:
+            return "value";
+    }
+}
+
+inline bool fits(Annotation type, Value value) {
+    switch (type) {
+        case Annotation::NONE:
+            return true;
+        case Annotation::NUMBER:
+            return value.is_number();
+        case Annotation::WHOLE:
+            if (value.is_int()) return true;
+            return value.is_number() &&
+                   value.as_number() == std::floor(value.as_number());
+        case Annotation::UNSIGNED:
+            if (value.is_int()) return value.as_int() >= 0;
+            return value.is_number() && value.as_number() >= 0 &&
+                   value.as_number() == std::floor(value.as_number());
+        case Annotation::CHAR:
+            return value.type() == ValueType::STRING &&
+                   value.as<StringValue>()->value.size() == 1;
+    }
+    return false;
 }
 
 template <>
-struct fmt::formatter<LiteralValue> : fmt::formatter<std::string> {
-    auto format(LiteralValue &v, fmt::format_context &ctx) const {
+struct fmt::formatter<Value> : fmt::formatter<std::string> {
+    auto format(Value v, fmt::format_context &ctx) const {
         // use fmt inside to build a string
         return fmt::formatter<std::string>::format(
             fmt::format("{}", literal_to_string(v)), ctx);
@@ -47,6 +47,14 @@ std::string type_to_string(TokenType type) {
             return "Number";
         case TokenType::ASSIGNMENT:
             return "Assignment";
+        case TokenType::PLUS_ASSIGN:
+            return "+=";
+        case TokenType::MINUS_ASSIGN:
+            return "-=";
+        case TokenType::MUL_ASSIGN:
+            return "*=";
+        case TokenType::DIV_ASSIGN:
+            return "/=";
         case TokenType::PLUS:
             return "Plus";
         case TokenType::MUL:
@@ -37,6 +37,10 @@ enum class TokenType {
     STRING,
     COMMENT,
     ASSIGNMENT,
+    PLUS_ASSIGN,
+    MINUS_ASSIGN,
+    MUL_ASSIGN,
+    DIV_ASSIGN,
     NOT,
     EQUALS,
     GT,
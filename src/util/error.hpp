@@ -19,6 +19,8 @@ class Error {
         ZERO_DIVISION_ERROR,
         TYPE_ERROR,
         FILE_NOT_FOUND_ERROR,
+        RECURSION_ERROR,
+        TIMEOUT_ERROR,
     };
     Error(Code code, const std::string &message = "");
 
@@ -68,6 +70,12 @@ struct fmt::formatter<Error::Code> : fmt::formatter<std::string> {
             case Error::Code::FILE_NOT_FOUND_ERROR:
                 code_str = "File Not Found Error";
                 break;
+            case Error::Code::RECURSION_ERROR:
+                code_str = "Recursion Error";
+                break;
+            case Error::Code::TIMEOUT_ERROR:
+                code_str = "Timeout Error";
+                break;
         }
         // use fmt inside to build a string
         return fmt::formatter<std::string>::format(fmt::format("{}", code_str),
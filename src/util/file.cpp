@@ -20,3 +20,10 @@ std::string load_file(const std::string &file_name) {
     throw Error(Error::Code::FILE_NOT_FOUND_ERROR,
                 fmt::format("File '{}' could not be found.", file_name));
 }
+
+void save_file(const std::string &file_name, const std::string &contents) {
+    std::ofstream t(file_name);
+    if (t << contents) return;
+    throw Error(Error::Code::FILE_NOT_FOUND_ERROR,
+                fmt::format("File '{}' could not be written.", file_name));
+}
@@ -6,5 +6,6 @@
 #include "util/error.hpp"
 
 std::string load_file(const std::string &file_name);
+void save_file(const std::string &file_name, const std::string &contents);
 
 #endif // UTIL_FILE_HPP
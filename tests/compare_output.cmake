@@ -0,0 +1,20 @@
+# cmake -DCHOCO=<choco> -DPROGRAM=<native> -DSCRIPT=<file.choco> -P ...
+#
+# the script run by the interpreter and the program choco_add_executable
+# built from it have to print the same thing and exit with the same code
+execute_process(
+    COMMAND ${CHOCO} ${SCRIPT}
+    OUTPUT_VARIABLE expected
+    RESULT_VARIABLE expected_code
+)
+execute_process(
+    COMMAND ${PROGRAM}
+    OUTPUT_VARIABLE actual
+    RESULT_VARIABLE actual_code
+)
+if(NOT expected STREQUAL actual OR NOT expected_code STREQUAL actual_code)
+    message(FATAL_ERROR
+        "${SCRIPT}: the --emit-cpp build differs from the interpreter\n"
+        "interpreter (exit ${expected_code}):\n${expected}\n"
+        "native (exit ${actual_code}):\n${actual}")
+endif()
@@ -1,6 +1,7 @@
 #include <fmt/base.h>
 #include <gtest/gtest.h>
 
+#include <filesystem>
 #include <string>
 
 #include "lexer.hpp"
@@ -27,11 +28,21 @@ class InterpreterTest : public testing::Test {
         return tokens;
     }
     std::string run_and_capture(const std::string &filename) {
+        return run_and_capture(interpreter, filename);
+    }
+    std::string run_and_capture(Interpreter &interpreter,
+                                const std::string &filename) {
         testing::internal::CaptureStdout();
         Lexer lexer(load_file(filename));
         const auto &tokens = tokenize(&lexer);
         Parser parser(tokens);
-        interpreter.eval(parser.parse());
+        // errors are part of the expected output, same as main.cpp
+        try {
+            interpreter.eval(parser.parse());
+            while (interpreter.paused()) interpreter.resume();
+        } catch (const Error &error) {
+            error.output_error();
+        }
         return testing::internal::GetCapturedStdout();
     }
 
@@ -48,4 +59,76 @@ TEST_F(InterpreterTest, CheckArrayStrings) {
               run_and_capture("./tests/cases/expression.choco"));
     EXPECT_EQ(load_file("./tests/out/loop_func_struct.output"),
               run_and_capture("./tests/cases/loop_func_struct.choco"));
+    EXPECT_EQ(load_file("./tests/out/constant_folding.output"),
+              run_and_capture("./tests/cases/constant_folding.choco"));
+    EXPECT_EQ(load_file("./tests/out/box_shapes.output"),
+              run_and_capture("./tests/cases/box_shapes.choco"));
+    EXPECT_EQ(load_file("./tests/out/short_circuit.output"),
+              run_and_capture("./tests/cases/short_circuit.choco"));
+    EXPECT_EQ(load_file("./tests/out/deep_recursion.output"),
+              run_and_capture("./tests/cases/deep_recursion.choco"));
+    EXPECT_EQ(load_file("./tests/out/numeric.output"),
+              run_and_capture("./tests/cases/numeric.choco"));
+    EXPECT_EQ(load_file("./tests/out/quickening.output"),
+              run_and_capture("./tests/cases/quickening.choco"));
+    EXPECT_EQ(load_file("./tests/out/redundant_loads.output"),
+              run_and_capture("./tests/cases/redundant_loads.choco"));
+    EXPECT_EQ(load_file("./tests/out/inlining.output"),
+              run_and_capture("./tests/cases/inlining.choco"));
+    EXPECT_EQ(load_file("./tests/out/compound_assignment.output"),
+              run_and_capture("./tests/cases/compound_assignment.choco"));
+    EXPECT_EQ(load_file("./tests/out/subscripts.output"),
+              run_and_capture("./tests/cases/subscripts.choco"));
+    EXPECT_EQ(load_file("./tests/out/type_annotations.output"),
+              run_and_capture("./tests/cases/type_annotations.choco"));
+    EXPECT_EQ(load_file("./tests/out/integers.output"),
+              run_and_capture("./tests/cases/integers.choco"));
+    EXPECT_EQ(load_file("./tests/out/scalar_replacement.output"),
+              run_and_capture("./tests/cases/scalar_replacement.choco"));
+    EXPECT_EQ(load_file("./tests/out/string_concat.output"),
+              run_and_capture("./tests/cases/string_concat.choco"));
+    EXPECT_EQ(load_file("./tests/out/box_templates.output"),
+              run_and_capture("./tests/cases/box_templates.choco"));
+    EXPECT_EQ(load_file("./tests/out/box_methods.output"),
+              run_and_capture("./tests/cases/box_methods.choco"));
+    EXPECT_EQ(load_file("./tests/out/string_aliasing.output"),
+              run_and_capture("./tests/cases/string_aliasing.choco"));
+}
+
+// compiling every confection on its first call must not change the output,
+// nothing is inlined on that side so the calls stay calls
+TEST_F(InterpreterTest, JitMatchesInterpreter) {
+    for (const auto &entry :
+         std::filesystem::directory_iterator("./tests/cases")) {
+        std::string file = entry.path().string();
+        Interpreter interpreted{{.jit = false}};
+        Interpreter compiled{{.jit = true,
+                              .jit_threshold = 0,
+                              .inlining = {.enabled = false}}};
+        EXPECT_EQ(run_and_capture(interpreted, file),
+                  run_and_capture(compiled, file))
+            << file;
+    }
+}
+
+// a paused program carries on where it stopped, however often it yields the
+// output is the same
+TEST_F(InterpreterTest, BudgetYieldsAndResumes) {
+    for (const auto &entry :
+         std::filesystem::directory_iterator("./tests/cases")) {
+        std::string file = entry.path().string();
+        Interpreter whole{{.jit = false}};
+        Interpreter sliced{{.budget = 3, .yield = true}};
+        EXPECT_EQ(run_and_capture(whole, file),
+                  run_and_capture(sliced, file))
+            << file;
+    }
+}
+
+// without yield a spent budget stops the program with an error
+TEST_F(InterpreterTest, BudgetTimesOut) {
+    Interpreter limited{{.budget = 1000}};
+    std::string output =
+        run_and_capture(limited, "./tests/cases/deep_recursion.choco");
+    EXPECT_NE(output.find("Timeout Error"), std::string::npos) << output;
 }